@@ -0,0 +1,100 @@
+/*!
+ \file arene.c
+ \brief Module fournissant la mémoire de travail d'un tour de simulation, par
+        allocation linéaire dans une arène remise à zéro à chaque tour
+ \author agent
+ \group Sylvain Pellegrini
+		Simon Gilgien
+ \version 1.0
+ \date 19 octobre 2026
+ */
+
+#include <stdlib.h>
+#include <stdalign.h>
+#include "arene.h"
+
+#define TAILLE_MIN		4096
+#define ALIGNEMENT		alignof(max_align_t)
+
+// bloc de débordement, alloué quand l'arène est pleine au cours d'un tour et
+// libéré au tour suivant
+typedef struct Debordement DEBORDEMENT;
+struct Debordement
+{
+	DEBORDEMENT *suivant;
+	max_align_t donnees[];
+};
+
+static unsigned char *base = NULL;
+static size_t capacite = 0;
+static size_t utilise = 0;
+static DEBORDEMENT *debordements = NULL;
+static size_t total_tour = 0;
+static size_t pic = 0;
+static unsigned long nb_allocations = 0;
+
+static size_t arene_arrondir(size_t taille);
+
+void arene_reinitialiser(void)
+{
+	DEBORDEMENT *bloc;
+
+	if (debordements)
+	{
+		while ((bloc = debordements))
+		{
+			debordements = bloc->suivant;
+			free(bloc);
+		}
+		capacite = pic > TAILLE_MIN ? pic : TAILLE_MIN;
+		free(base);
+		if (!(base = malloc(capacite)))
+			exit(EXIT_FAILURE);
+		nb_allocations++;
+	}
+	utilise = 0;
+	total_tour = 0;
+}
+
+void* arene_allouer(size_t taille)
+{
+	DEBORDEMENT *bloc;
+	void *zone;
+
+	taille = arene_arrondir(taille);
+	total_tour += taille;
+	if (total_tour > pic)
+		pic = total_tour;
+	if (!base)
+	{
+		capacite = taille > TAILLE_MIN ? taille : TAILLE_MIN;
+		if (!(base = malloc(capacite)))
+			exit(EXIT_FAILURE);
+		nb_allocations++;
+	}
+	if (utilise + taille <= capacite)
+	{
+		zone = base + utilise;
+		utilise += taille;
+		return zone;
+	}
+	// les zones déjà données restent valables: le complément vient du tas
+	// jusqu'à la fin du tour
+	if (!(bloc = malloc(sizeof(DEBORDEMENT) + taille)))
+		exit(EXIT_FAILURE);
+	nb_allocations++;
+	bloc->suivant = debordements;
+	debordements = bloc;
+	return bloc->donnees;
+}
+
+void arene_statistiques(size_t *p_pic, unsigned long *p_allocations)
+{
+	*p_pic = pic;
+	*p_allocations = nb_allocations;
+}
+
+static size_t arene_arrondir(size_t taille)
+{
+	return (taille + ALIGNEMENT - 1)/ALIGNEMENT*ALIGNEMENT;
+}
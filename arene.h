@@ -0,0 +1,40 @@
+/*!
+ \file arene.h
+ \brief Module fournissant la mémoire de travail d'un tour de simulation, par
+        allocation linéaire dans une arène remise à zéro à chaque tour
+ \author agent
+ \group Sylvain Pellegrini
+		Simon Gilgien
+ \version 1.0
+ \date 19 octobre 2026
+ */
+
+#ifndef ARENE_H
+#define ARENE_H
+
+#include <stddef.h>
+
+/**
+ * \brief	Libère d'un coup tout ce qui a été alloué depuis l'appel précédent.
+ *			Si le tour a débordé de l'arène, elle est agrandie une fois pour
+ *			toutes à la taille atteinte: en régime établi, un tour ne fait plus
+ *			aucun appel au tas.
+ */
+void arene_reinitialiser(void);
+
+/**
+ * \brief	Alloue une zone de travail valable jusqu'au prochain
+ *			arene_reinitialiser(). Quitte le programme si la mémoire manque.
+ * \param taille	La taille en octets.
+ * \return	Une zone alignée pour tout type.
+ */
+void* arene_allouer(size_t taille);
+
+/**
+ * \brief	Donne l'usage de l'arène depuis le début du programme.
+ * \param p_pic			Reçoit la plus grande taille utilisée en un tour.
+ * \param p_allocations	Reçoit le nombre d'appels au tas faits par l'arène.
+ */
+void arene_statistiques(size_t *p_pic, unsigned long *p_allocations);
+
+#endif
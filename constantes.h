@@ -13,11 +13,16 @@
 
 #include "tolerance.h"
 
+// le pas de temps peut être augmenté à la compilation (-DDELTA_T=...), les 
+// collisions étant détectées de façon continue sur tout le déplacement
+#ifndef DELTA_T
 #define DELTA_T				0.25
+#endif
 #define VTRAN_MAX			0.75
 #define VROT_MAX			0.5
 #define DELTA_VROT			0.125
 #define DELTA_VTRAN			0.25
+// demi-largeur du monde par défaut, modifiable par une ligne "DMAX" du scénario
 #define DMAX 				20
 #define R_ROBOT				0.5
 #define R_PARTICULE_MAX		4
@@ -25,7 +30,10 @@
 #define R_PARTICULE_FACTOR	0.4142
 #define E_PARTICULE_MAX 	1
 #define E_PARTICULE_FACTOR	0.25
+// chance de décomposition par tour au pas de référence; la chance par unité de
+// temps ne dépend pas de DELTA_T (voir particule_programmer)
 #define DECOMPOSITION_RATE	0.025
+#define DELTA_T_REFERENCE	0.25
 #define MAX_LINE 			120
 #define CENT_POUR_CENT		100
 
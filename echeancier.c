@@ -0,0 +1,159 @@
+/*!
+ \file echeancier.c
+ \brief Module d'échéancier: roue de temporisation hiérarchique qui donne, à
+        chaque tour, les éléments arrivés à échéance sans parcourir les autres
+ \author agent
+ \group Sylvain Pellegrini
+		Simon Gilgien
+ \version 1.0
+ \date 19 octobre 2026
+ */
+
+#include <stdlib.h>
+#include <assert.h>
+#include "echeancier.h"
+
+// le niveau n compte NB_CRANS crans de NB_CRANS^n tours. Un élément est rangé au
+// plus petit niveau où son échéance partage avec le tour courant les bits
+// au-dessus des crans du niveau, et redescend quand son cran est atteint. Au-delà
+// du dernier niveau (2^24 tours), il est rangé à nouveau à chaque tour de roue
+// du dernier niveau jusqu'à s'en approcher.
+#define BITS_CRAN			6
+#define NB_CRANS			(1 << BITS_CRAN)
+#define NB_NIVEAUX			4
+#define CAPACITE_CRAN_MIN	16
+
+typedef struct Element ELEMENT;
+typedef struct Cran CRAN;
+struct Element
+{
+	int id;
+	unsigned int echeance;
+};
+
+struct Cran
+{
+	int nb;
+	int capacite;
+	ELEMENT *elements;
+};
+
+static CRAN roue[NB_NIVEAUX][NB_CRANS];
+static unsigned int tour = 0;
+// cran vide échangé avec celui qui redescend, pour garder sa mémoire
+static CRAN tampon = {0, 0, NULL};
+static int *dus = NULL;
+static int capacite_dus = 0;
+
+static void echeancier_ranger(ELEMENT element);
+
+void echeancier_programmer(int id, unsigned int echeance)
+{
+	ELEMENT element = {id, echeance};
+
+	assert(echeance > tour);
+	echeancier_ranger(element);
+}
+
+unsigned int echeancier_tour(void)
+{
+	return tour;
+}
+
+// les niveaux supérieurs redescendent d'abord: leurs éléments peuvent arriver
+// dans un cran inférieur qui redescend au même tour
+int echeancier_avancer(int **p_ids)
+{
+	int niveau, k, nb_dus;
+	CRAN *cran, detache;
+
+	tour++;
+	for (niveau = NB_NIVEAUX-1; niveau > 0; niveau--)
+	{
+		if (tour & ((1u << BITS_CRAN*niveau) - 1))
+			continue;
+		cran = &roue[niveau][(tour >> BITS_CRAN*niveau) & (NB_CRANS-1)];
+		detache = *cran;
+		*cran = tampon;
+		for (k = 0; k < detache.nb; k++)
+			echeancier_ranger(detache.elements[k]);
+		tampon = detache;
+		tampon.nb = 0;
+	}
+	cran = &roue[0][tour & (NB_CRANS-1)];
+	if (cran->nb > capacite_dus)
+	{
+		capacite_dus = cran->capacite;
+		if (!(dus = realloc(dus, capacite_dus*sizeof(int))))
+			exit(EXIT_FAILURE);
+	}
+	for (k = 0; k < cran->nb; k++)
+		dus[k] = cran->elements[k].id;
+	nb_dus = cran->nb;
+	cran->nb = 0;
+	*p_ids = dus;
+	return nb_dus;
+}
+
+void echeancier_renumeroter(const int *nouveaux)
+{
+	int niveau, c, k, n;
+	CRAN *cran;
+
+	for (niveau = 0; niveau < NB_NIVEAUX; niveau++)
+	{
+		for (c = 0; c < NB_CRANS; c++)
+		{
+			cran = &roue[niveau][c];
+			for (k = 0, n = 0; k < cran->nb; k++)
+			{
+				if (nouveaux[cran->elements[k].id] < 0)
+					continue;
+				cran->elements[n].id = nouveaux[cran->elements[k].id];
+				cran->elements[n].echeance = cran->elements[k].echeance;
+				n++;
+			}
+			cran->nb = n;
+		}
+	}
+}
+
+void echeancier_vider(void)
+{
+	int niveau, c;
+
+	for (niveau = 0; niveau < NB_NIVEAUX; niveau++)
+	{
+		for (c = 0; c < NB_CRANS; c++)
+		{
+			free(roue[niveau][c].elements);
+			roue[niveau][c] = (CRAN){0, 0, NULL};
+		}
+	}
+	free(tampon.elements);
+	tampon = (CRAN){0, 0, NULL};
+	free(dus);
+	dus = NULL;
+	capacite_dus = 0;
+	tour = 0;
+}
+
+static void echeancier_ranger(ELEMENT element)
+{
+	int niveau = 0;
+	CRAN *cran;
+
+	while (niveau < NB_NIVEAUX-1 &&
+		   element.echeance >> BITS_CRAN*(niveau+1) !=
+		   tour >> BITS_CRAN*(niveau+1))
+		niveau++;
+	cran = &roue[niveau][(element.echeance >> BITS_CRAN*niveau) & (NB_CRANS-1)];
+	if (cran->nb == cran->capacite)
+	{
+		cran->capacite = cran->capacite ? 2*cran->capacite : CAPACITE_CRAN_MIN;
+		if (!(cran->elements = realloc(cran->elements,
+									   cran->capacite*sizeof(ELEMENT))))
+			exit(EXIT_FAILURE);
+	}
+	cran->elements[cran->nb++] = element;
+}
@@ -0,0 +1,49 @@
+/*!
+ \file echeancier.h
+ \brief Module d'échéancier: roue de temporisation hiérarchique qui donne, à
+        chaque tour, les éléments arrivés à échéance sans parcourir les autres
+ \author agent
+ \group Sylvain Pellegrini
+		Simon Gilgien
+ \version 1.0
+ \date 19 octobre 2026
+ */
+
+#ifndef ECHEANCIER_H
+#define ECHEANCIER_H
+
+/**
+ * \brief	Programme un élément pour un tour à venir. Un élément peut être
+ *			programmé plusieurs fois, il est alors donné autant de fois.
+ * \param id		L'identifiant de l'élément, positif ou nul.
+ * \param echeance	Le tour où l'élément sera donné, après le tour courant.
+ */
+void echeancier_programmer(int id, unsigned int echeance);
+
+/**
+ * \brief	Retourne le tour courant, 0 au départ et après echeancier_vider().
+ */
+unsigned int echeancier_tour(void);
+
+/**
+ * \brief	Passe au tour suivant et donne les éléments programmés pour ce tour,
+ *			dans un ordre quelconque, en O(1) par élément amorti.
+ * \param p_ids	Reçoit un tableau des identifiants, valable jusqu'à l'appel
+ *				suivant; programmer d'autres éléments ne le modifie pas.
+ * \return	Le nombre d'identifiants.
+ */
+int echeancier_avancer(int **p_ids);
+
+/**
+ * \brief	Renumérote les éléments programmés: id devient nouveaux[id], et
+ *			l'élément est retiré si nouveaux[id] est négatif.
+ * \param nouveaux	Tableau couvrant tous les identifiants programmés.
+ */
+void echeancier_renumeroter(const int *nouveaux);
+
+/**
+ * \brief	Retire tous les éléments, libère l'échéancier et remet le tour à 0.
+ */
+void echeancier_vider(void);
+
+#endif
@@ -0,0 +1,445 @@
+/*!
+ \file ecriture.c
+ \brief Module d'écriture rapide des fichiers de scénario: réels convertis en
+        leur plus courte écriture décimale qui se relit à l'identique, et
+        lignes formatées par blocs dans de grands tampons, par plusieurs fils
+ \author agent
+ \group Sylvain Pellegrini
+		Simon Gilgien
+ \version 1.0
+ \date 19 octobre 2026
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include "ecriture.h"
+
+#define LIGNES_BLOC			16384
+#define NB_FILS_MAX			64
+#define BITS_MANTISSE		52
+#define BIAIS_EXPOSANT		1075
+#define BIT_CACHE			((uint64_t)1 << BITS_MANTISSE)
+#define MASQUE_MANTISSE		(BIT_CACHE - 1)
+#define PREMIERE_PUISSANCE	-348
+#define PAS_PUISSANCES		8
+#define CHIFFRES_DECIMAUX	21
+#define CHIFFRES_ZEROS		6
+#define NB_PUISSANCES_DIX	20
+
+// réel binaire f*2^e sans arrondi de la mantisse, sur 64 bits
+typedef struct Diy DIY;
+struct Diy
+{
+	uint64_t f;
+	int e;
+};
+
+// un bloc de lignes formaté par un fil, écrit ensuite d'un seul fwrite
+typedef struct Bloc BLOC;
+struct Bloc
+{
+	char *texte;
+	size_t taille;
+};
+
+typedef struct Travail TRAVAIL;
+struct Travail
+{
+	int nb;
+	int taille_max;
+	int premier_bloc;
+	int nb_blocs;
+	int (*formater)(char *texte, int i, const void *donnees);
+	const void *donnees;
+	BLOC *blocs;
+	atomic_int bloc_suivant;
+};
+
+// 10^k arrondi sur 64 bits, pour k de -348 à 340 par pas de 8: f*2^e
+static const uint64_t puissances_f[] =
+{
+	0xfa8fd5a0081c0288ULL, 0xbaaee17fa23ebf76ULL, 0x8b16fb203055ac76ULL,
+	0xcf42894a5dce35eaULL, 0x9a6bb0aa55653b2dULL, 0xe61acf033d1a45dfULL,
+	0xab70fe17c79ac6caULL, 0xff77b1fcbebcdc4fULL, 0xbe5691ef416bd60cULL,
+	0x8dd01fad907ffc3cULL, 0xd3515c2831559a83ULL, 0x9d71ac8fada6c9b5ULL,
+	0xea9c227723ee8bcbULL, 0xaecc49914078536dULL, 0x823c12795db6ce57ULL,
+	0xc21094364dfb5637ULL, 0x9096ea6f3848984fULL, 0xd77485cb25823ac7ULL,
+	0xa086cfcd97bf97f4ULL, 0xef340a98172aace5ULL, 0xb23867fb2a35b28eULL,
+	0x84c8d4dfd2c63f3bULL, 0xc5dd44271ad3cdbaULL, 0x936b9fcebb25c996ULL,
+	0xdbac6c247d62a584ULL, 0xa3ab66580d5fdaf6ULL, 0xf3e2f893dec3f126ULL,
+	0xb5b5ada8aaff80b8ULL, 0x87625f056c7c4a8bULL, 0xc9bcff6034c13053ULL,
+	0x964e858c91ba2655ULL, 0xdff9772470297ebdULL, 0xa6dfbd9fb8e5b88fULL,
+	0xf8a95fcf88747d94ULL, 0xb94470938fa89bcfULL, 0x8a08f0f8bf0f156bULL,
+	0xcdb02555653131b6ULL, 0x993fe2c6d07b7facULL, 0xe45c10c42a2b3b06ULL,
+	0xaa242499697392d3ULL, 0xfd87b5f28300ca0eULL, 0xbce5086492111aebULL,
+	0x8cbccc096f5088ccULL, 0xd1b71758e219652cULL, 0x9c40000000000000ULL,
+	0xe8d4a51000000000ULL, 0xad78ebc5ac620000ULL, 0x813f3978f8940984ULL,
+	0xc097ce7bc90715b3ULL, 0x8f7e32ce7bea5c70ULL, 0xd5d238a4abe98068ULL,
+	0x9f4f2726179a2245ULL, 0xed63a231d4c4fb27ULL, 0xb0de65388cc8ada8ULL,
+	0x83c7088e1aab65dbULL, 0xc45d1df942711d9aULL, 0x924d692ca61be758ULL,
+	0xda01ee641a708deaULL, 0xa26da3999aef774aULL, 0xf209787bb47d6b85ULL,
+	0xb454e4a179dd1877ULL, 0x865b86925b9bc5c2ULL, 0xc83553c5c8965d3dULL,
+	0x952ab45cfa97a0b3ULL, 0xde469fbd99a05fe3ULL, 0xa59bc234db398c25ULL,
+	0xf6c69a72a3989f5cULL, 0xb7dcbf5354e9beceULL, 0x88fcf317f22241e2ULL,
+	0xcc20ce9bd35c78a5ULL, 0x98165af37b2153dfULL, 0xe2a0b5dc971f303aULL,
+	0xa8d9d1535ce3b396ULL, 0xfb9b7cd9a4a7443cULL, 0xbb764c4ca7a44410ULL,
+	0x8bab8eefb6409c1aULL, 0xd01fef10a657842cULL, 0x9b10a4e5e9913129ULL,
+	0xe7109bfba19c0c9dULL, 0xac2820d9623bf429ULL, 0x80444b5e7aa7cf85ULL,
+	0xbf21e44003acdd2dULL, 0x8e679c2f5e44ff8fULL, 0xd433179d9c8cb841ULL,
+	0x9e19db92b4e31ba9ULL, 0xeb96bf6ebadf77d9ULL, 0xaf87023b9bf0ee6bULL
+};
+
+static const int16_t puissances_e[] =
+{
+	-1220, -1193, -1166, -1140, -1113, -1087, -1060, -1034, -1007, -980,
+	-954, -927, -901, -874, -847, -821, -794, -768, -741, -715,
+	-688, -661, -635, -608, -582, -555, -529, -502, -475, -449,
+	-422, -396, -369, -343, -316, -289, -263, -236, -210, -183,
+	-157, -130, -103, -77, -50, -24, 3, 30, 56, 83,
+	109, 136, 162, 189, 216, 242, 269, 295, 322, 348,
+	375, 402, 428, 455, 481, 508, 534, 561, 588, 614,
+	641, 667, 694, 720, 747, 774, 800, 827, 853, 880,
+	907, 933, 960, 986, 1013, 1039, 1066
+};
+
+static const uint64_t puissances_dix[] =
+{
+	1ULL, 10ULL, 100ULL, 1000ULL, 10000ULL, 100000ULL, 1000000ULL, 10000000ULL,
+	100000000ULL, 1000000000ULL, 10000000000ULL, 100000000000ULL,
+	1000000000000ULL, 10000000000000ULL, 100000000000000ULL,
+	1000000000000000ULL, 10000000000000000ULL, 100000000000000000ULL,
+	1000000000000000000ULL, 10000000000000000000ULL
+};
+
+static int nb_fils = 1;
+
+static DIY ecriture_diy(double x);
+static DIY ecriture_normaliser(DIY x);
+static DIY ecriture_moins(DIY a, DIY b);
+static DIY ecriture_fois(DIY a, DIY b);
+static void ecriture_bornes(DIY v, DIY *p_moins, DIY *p_plus);
+static DIY ecriture_puissance(int e, int *p_k);
+static int ecriture_nb_chiffres(uint32_t n);
+static void ecriture_arrondir(char *chiffres, int longueur, uint64_t delta,
+							  uint64_t reste, uint64_t dix_kappa, uint64_t ecart);
+static void ecriture_chiffres(DIY w, DIY plus, uint64_t delta, char *chiffres,
+							  int *p_longueur, int *p_k);
+static int ecriture_mettre_en_forme(char *texte, int longueur, int k);
+static int ecriture_exposant(char *texte, int k);
+static void* ecriture_travailler(void *travail);
+
+// Grisu2 (Loitsch, "Printing floating-point numbers quickly and accurately
+// with integers", 2010): les chiffres sont produits dans l'intervalle des réels
+// qui s'arrondissent vers x, resserré d'une unité pour couvrir l'erreur des
+// produits sur 64 bits. Le résultat se relit toujours à l'identique et n'est
+// qu'exceptionnellement plus long que le plus court possible.
+int ecriture_reel(char *texte, double x)
+{
+	DIY v, moins, plus, w, c;
+	char *debut = texte;
+	int longueur, k;
+
+	if (!isfinite(x))
+		return snprintf(texte, ECRITURE_REEL_MAX, "%.17g", x);
+	if (signbit(x))
+	{
+		*texte++ = '-';
+		x = -x;
+	}
+	if (x == 0.)
+	{
+		*texte++ = '0';
+		*texte = '\0';
+		return texte - debut;
+	}
+	v = ecriture_diy(x);
+	ecriture_bornes(v, &moins, &plus);
+	c = ecriture_puissance(plus.e, &k);
+	w = ecriture_fois(ecriture_normaliser(v), c);
+	plus = ecriture_fois(plus, c);
+	moins = ecriture_fois(moins, c);
+	moins.f++;
+	plus.f--;
+	ecriture_chiffres(w, plus, plus.f - moins.f, texte, &longueur, &k);
+	return texte - debut + ecriture_mettre_en_forme(texte, longueur, k);
+}
+
+void ecriture_set_nb_fils(int fils)
+{
+	nb_fils = fils < 1 ? 1 : fils > NB_FILS_MAX ? NB_FILS_MAX : fils;
+}
+
+// les blocs sont traités par tours de nb_fils blocs: le fil appelant formate
+// aussi, puis écrit les blocs du tour dans l'ordre
+bool ecriture_lignes(FILE *fichier, int nb, int taille_max,
+					 int (*formater)(char *texte, int i, const void *donnees),
+					 const void *donnees)
+{
+	pthread_t fils[NB_FILS_MAX];
+	bool lance[NB_FILS_MAX];
+	BLOC blocs[NB_FILS_MAX];
+	TRAVAIL travail = {nb, taille_max, 0, 0, formater, donnees, blocs, 0};
+	int nb_blocs = (nb + LIGNES_BLOC - 1)/LIGNES_BLOC;
+	int fils_tour = nb_blocs < nb_fils ? nb_blocs : nb_fils;
+	bool succes = true;
+	int i, b;
+
+	for (b = 0; b < fils_tour; b++)
+		if (!(blocs[b].texte = malloc((size_t)LIGNES_BLOC*taille_max)))
+			exit(EXIT_FAILURE);
+	for (travail.premier_bloc = 0; travail.premier_bloc < nb_blocs;
+		 travail.premier_bloc += fils_tour)
+	{
+		travail.nb_blocs = nb_blocs - travail.premier_bloc < fils_tour ?
+						   nb_blocs - travail.premier_bloc : fils_tour;
+		atomic_store(&travail.bloc_suivant, 0);
+		for (i = 1; i < travail.nb_blocs; i++)
+			lance[i] = !pthread_create(&fils[i], NULL, ecriture_travailler,
+									   &travail);
+		ecriture_travailler(&travail);
+		for (i = 1; i < travail.nb_blocs; i++)
+			if (lance[i])
+				pthread_join(fils[i], NULL);
+		for (b = 0; b < travail.nb_blocs && succes; b++)
+			succes = fwrite(blocs[b].texte, 1, blocs[b].taille, fichier) ==
+					 blocs[b].taille;
+	}
+	for (b = 0; b < fils_tour; b++)
+		free(blocs[b].texte);
+	return succes;
+}
+
+static DIY ecriture_diy(double x)
+{
+	uint64_t bits;
+	int exposant;
+	DIY v;
+
+	memcpy(&bits, &x, sizeof(bits));
+	exposant = (int)((bits >> BITS_MANTISSE) & 0x7FF);
+	if (exposant)
+	{
+		v.f = (bits & MASQUE_MANTISSE) + BIT_CACHE;
+		v.e = exposant - BIAIS_EXPOSANT;
+	}
+	else
+	{
+		v.f = bits & MASQUE_MANTISSE;
+		v.e = 1 - BIAIS_EXPOSANT;
+	}
+	return v;
+}
+
+static DIY ecriture_normaliser(DIY x)
+{
+	while (!(x.f & ((uint64_t)1 << 63)))
+	{
+		x.f <<= 1;
+		x.e--;
+	}
+	return x;
+}
+
+static DIY ecriture_moins(DIY a, DIY b)
+{
+	DIY d = {a.f - b.f, a.e};
+	return d;
+}
+
+// 64 bits de poids fort du produit, arrondis
+static DIY ecriture_fois(DIY a, DIY b)
+{
+	const uint64_t masque = 0xFFFFFFFFu;
+	uint64_t ah = a.f >> 32, al = a.f & masque, bh = b.f >> 32, bl = b.f & masque;
+	uint64_t hh = ah*bh, lh = al*bh, hl = ah*bl, ll = al*bl;
+	uint64_t milieu = (ll >> 32) + (hl & masque) + (lh & masque) + (1u << 31);
+	DIY p = {hh + (hl >> 32) + (lh >> 32) + (milieu >> 32), a.e + b.e + 64};
+	return p;
+}
+
+// milieux entre v et ses voisins, plus sur 64 bits normalisés et moins au même
+// exposant; l'écart vers le voisin inférieur est deux fois plus petit quand v
+// est une puissance de deux
+static void ecriture_bornes(DIY v, DIY *p_moins, DIY *p_plus)
+{
+	DIY plus = {(v.f << 1) + 1, v.e - 1}, moins;
+
+	while (!(plus.f & (BIT_CACHE << 1)))
+	{
+		plus.f <<= 1;
+		plus.e--;
+	}
+	plus.f <<= 64 - BITS_MANTISSE - 2;
+	plus.e -= 64 - BITS_MANTISSE - 2;
+	if (v.f == BIT_CACHE)
+	{
+		moins.f = (v.f << 2) - 1;
+		moins.e = v.e - 2;
+	}
+	else
+	{
+		moins.f = (v.f << 1) - 1;
+		moins.e = v.e - 1;
+	}
+	moins.f <<= moins.e - plus.e;
+	moins.e = plus.e;
+	*p_moins = moins;
+	*p_plus = plus;
+}
+
+// puissance de dix 10^-k qui ramène l'exposant binaire e entre -60 et -32
+static DIY ecriture_puissance(int e, int *p_k)
+{
+	double dk = (-61 - e)*0.30102999566398114 + 347;
+	int k = (int)dk, indice;
+	DIY c;
+
+	if (dk - k > 0.)
+		k++;
+	indice = (k >> 3) + 1;
+	*p_k = -(PREMIERE_PUISSANCE + indice*PAS_PUISSANCES);
+	c.f = puissances_f[indice];
+	c.e = puissances_e[indice];
+	return c;
+}
+
+static int ecriture_nb_chiffres(uint32_t n)
+{
+	int k = 1;
+
+	while (k < 10 && n >= puissances_dix[k])
+		k++;
+	return k;
+}
+
+// rapproche le dernier chiffre de w tant que le résultat reste dans l'intervalle
+static void ecriture_arrondir(char *chiffres, int longueur, uint64_t delta,
+							  uint64_t reste, uint64_t dix_kappa, uint64_t ecart)
+{
+	while (reste < ecart && delta - reste >= dix_kappa &&
+		   (reste + dix_kappa < ecart ||
+			ecart - reste > reste + dix_kappa - ecart))
+	{
+		chiffres[longueur-1]--;
+		reste += dix_kappa;
+	}
+}
+
+// chiffres de plus jusqu'à ce que le reste tienne dans l'intervalle de largeur
+// delta; p_k reçoit l'exposant décimal du dernier chiffre
+static void ecriture_chiffres(DIY w, DIY plus, uint64_t delta, char *chiffres,
+							  int *p_longueur, int *p_k)
+{
+	DIY un = {(uint64_t)1 << -plus.e, plus.e};
+	uint64_t ecart = ecriture_moins(plus, w).f;
+	uint32_t p1 = (uint32_t)(plus.f >> -un.e), chiffre;
+	uint64_t p2 = plus.f & (un.f - 1), reste;
+	int kappa = ecriture_nb_chiffres(p1), longueur = 0;
+
+	while (kappa > 0)
+	{
+		chiffre = p1/(uint32_t)puissances_dix[kappa-1];
+		p1 %= puissances_dix[kappa-1];
+		if (chiffre || longueur)
+			chiffres[longueur++] = '0' + chiffre;
+		kappa--;
+		reste = ((uint64_t)p1 << -un.e) + p2;
+		if (reste <= delta)
+		{
+			*p_k += kappa;
+			ecriture_arrondir(chiffres, longueur, delta, reste,
+							  puissances_dix[kappa] << -un.e, ecart);
+			*p_longueur = longueur;
+			return;
+		}
+	}
+	for (;;)
+	{
+		p2 *= 10;
+		delta *= 10;
+		chiffre = (uint32_t)(p2 >> -un.e);
+		if (chiffre || longueur)
+			chiffres[longueur++] = '0' + chiffre;
+		p2 &= un.f - 1;
+		kappa--;
+		if (p2 < delta)
+		{
+			*p_k += kappa;
+			ecriture_arrondir(chiffres, longueur, delta, p2, un.f,
+							  -kappa < NB_PUISSANCES_DIX ?
+							  ecart*puissances_dix[-kappa] : 0);
+			*p_longueur = longueur;
+			return;
+		}
+	}
+}
+
+// chiffres*10^k en notation décimale pour les ordres de grandeur usuels, sinon
+// en notation scientifique; texte contient déjà les chiffres
+static int ecriture_mettre_en_forme(char *texte, int longueur, int k)
+{
+	int n = longueur + k, i;
+
+	if (k >= 0 && n <= CHIFFRES_DECIMAUX)
+	{
+		for (i = longueur; i < n; i++)
+			texte[i] = '0';
+		texte[n] = '\0';
+		return n;
+	}
+	if (n > 0 && n <= CHIFFRES_DECIMAUX)
+	{
+		memmove(&texte[n+1], &texte[n], longueur - n);
+		texte[n] = '.';
+		texte[longueur+1] = '\0';
+		return longueur + 1;
+	}
+	if (n > -CHIFFRES_ZEROS && n <= 0)
+	{
+		memmove(&texte[2-n], texte, longueur);
+		texte[0] = '0';
+		texte[1] = '.';
+		for (i = 2; i < 2-n; i++)
+			texte[i] = '0';
+		texte[longueur+2-n] = '\0';
+		return longueur + 2 - n;
+	}
+	if (longueur == 1)
+	{
+		texte[1] = 'e';
+		return 2 + ecriture_exposant(&texte[2], n-1);
+	}
+	memmove(&texte[2], &texte[1], longueur - 1);
+	texte[1] = '.';
+	texte[longueur+1] = 'e';
+	return longueur + 2 + ecriture_exposant(&texte[longueur+2], n-1);
+}
+
+static int ecriture_exposant(char *texte, int k)
+{
+	return sprintf(texte, "%d", k);
+}
+
+// chaque fil prend le bloc suivant du tour jusqu'à épuisement
+static void* ecriture_travailler(void *travail)
+{
+	TRAVAIL *t = travail;
+	BLOC *bloc;
+	int b, i, fin;
+
+	while ((b = atomic_fetch_add(&t->bloc_suivant, 1)) < t->nb_blocs)
+	{
+		bloc = &t->blocs[b];
+		bloc->taille = 0;
+		i = (t->premier_bloc + b)*LIGNES_BLOC;
+		fin = i + LIGNES_BLOC < t->nb ? i + LIGNES_BLOC : t->nb;
+		for (; i < fin; i++)
+			bloc->taille += t->formater(&bloc->texte[bloc->taille], i, t->donnees);
+	}
+	return NULL;
+}
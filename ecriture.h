@@ -0,0 +1,53 @@
+/*!
+ \file ecriture.h
+ \brief Module d'écriture rapide des fichiers de scénario: réels convertis en
+        leur plus courte écriture décimale qui se relit à l'identique, et
+        lignes formatées par blocs dans de grands tampons, par plusieurs fils
+ \author agent
+ \group Sylvain Pellegrini
+		Simon Gilgien
+ \version 1.0
+ \date 19 octobre 2026
+ */
+
+#ifndef ECRITURE_H
+#define ECRITURE_H
+
+#include <stdio.h>
+#include <stdbool.h>
+
+// nombre maximal de caractères écrits par ecriture_reel(), zéro final compris
+#define ECRITURE_REEL_MAX	32
+
+/**
+ * \brief	Écrit un réel avec le moins de chiffres possible pour que sa
+ *			relecture (strtod, scanf "%lf") redonne exactement la même valeur.
+ * \param texte	Tampon d'au moins ECRITURE_REEL_MAX caractères.
+ * \param x		Le réel à écrire.
+ * \return	Le nombre de caractères écrits, sans le zéro final.
+ */
+int ecriture_reel(char *texte, double x);
+
+/**
+ * \brief	Fixe le nombre de fils utilisés par ecriture_lignes().
+ * \param nb_fils	Le nombre de fils, appelant compris; 1 par défaut.
+ */
+void ecriture_set_nb_fils(int nb_fils);
+
+/**
+ * \brief	Écrit nb lignes dans un fichier, dans l'ordre. Les lignes sont
+ *			formatées par blocs dans des tampons, en parallèle si plusieurs
+ *			fils sont permis, puis chaque tampon est écrit d'un seul appel.
+ * \param fichier	Le fichier ouvert en écriture.
+ * \param nb		Le nombre de lignes.
+ * \param taille_max	Le nombre maximal de caractères d'une ligne.
+ * \param formater	Fonction écrivant la ligne i dans texte, sans zéro final,
+ *					et retournant sa longueur; appelée depuis plusieurs fils.
+ * \param donnees	Pointeur transmis tel quel à formater.
+ * \return	Vrai si toutes les lignes ont été écrites.
+ */
+bool ecriture_lignes(FILE *fichier, int nb, int taille_max,
+					 int (*formater)(char *texte, int i, const void *donnees),
+					 const void *donnees);
+
+#endif
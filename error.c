@@ -64,11 +64,11 @@ void error_invalid_particule()
 }
 
 void error_invalid_particule_value(double energy, double radius,
-								   double x0, double y0)
+								   double x0, double y0, double dmax)
 {
 	printf("Error - Invalid particule informations %f %f %f %f \n",
 		   energy, radius, x0, y0);
-	printf("x0 and y0 must be in [%d ; %d]\n", -DMAX, DMAX);
+	printf("x0 and y0 must be in [%g ; %g]\n", -dmax, dmax);
 	printf("energy must be in [0 ; %d]\n", E_PARTICULE_MAX);
 	printf("radius must be in [%g ; %d]\n", R_PARTICULE_MIN, 
 											R_PARTICULE_MAX);
@@ -116,6 +116,12 @@ void error_collision(ERROR_COLLISION type,
 	printf("%s %d and %s %d\n", name_col[0], id1, name_col[1], id2);
 }
 
+void error_invalid_dmax(unsigned int line_number)
+{
+	printf("Error - Invalid world size on line %u, DMAX must be positive\n",
+		   line_number);
+}
+
 void error_end_of_file(unsigned int line_number)
 {
 	printf("Error - Unexpected End-Of-File after line %u\n", line_number);
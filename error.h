@@ -76,9 +76,10 @@ void error_invalid_particule();
  * \param	y0			coordonate on y-axis
  * \param	energy		energy of this particule
  * \param	radius		radius of this particule
+ * \param	dmax		half-width of the world read from the file
  */
 void error_invalid_particule_value(double energy, double radius,
-								   double x0, double y0);
+								   double x0, double y0, double dmax);
 
 /**
  * \brief	Unexpected "FIN_LISTE" when reading particules
@@ -109,6 +110,12 @@ void error_useless_char(unsigned int line_number);
 void error_collision(ERROR_COLLISION type, 
 				     unsigned int id1, unsigned int id2);
 
+/**
+ * \brief	the world size is invalid. it must be a positive number
+ * \param	line_number	line number of the "DMAX" line
+ */
+void error_invalid_dmax(unsigned int line_number);
+
 /**
  * \brief	detecting the end of the file despite the file analysis
  * 			is still on-going => we have not yet reached the final state
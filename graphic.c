@@ -11,25 +11,84 @@
 #include <GL/glu.h>
 #include <math.h>
 #include "graphic.h"
+#include "rendu.h"
 #include "constantes.h"
 
 #define COTES_CERCLE	50
+#define PIXELS_COTE		4.
+#define RAYON_POINT		0.5
+#define TAILLE_POINT	1.
+#define TAILLE_LOT		4096
+#define ZOOM_MIN		0.5
+#define ZOOM_MAX		1e5
 
 static double aspect_ratio = 1.;
 static int width, height;
 GLfloat x_min, x_max, y_min, y_max;
 
+// vue: agrandissement et décalage du centre par rapport au rectangle demandé à
+// graphic_begin_draw, conservés d'un dessin à l'autre
+static double zoom = 1.;
+static double decalage_x = 0., decalage_y = 0.;
+static double pixels_par_unite = 1.;
+
+// points en attente: les cercles de moins d'un pixel sont dessinés en un seul
+// lot par couleur, vidé avant toute autre primitive
+static GLfloat lot_points[2*TAILLE_LOT];
+static int nb_points = 0;
+static float couleur_points[3];
+
+// pas dans la table des sommets, du plus grossier au plus fin; chacun divise
+// COTES_CERCLE
+static const int pas_cercle[] = {10, 5, 2, 1};
+
+static const float couleur_fond[3] = {1., 1., 1.};
+
+static void graphic_point(double x, double y, float* couleur);
+static void graphic_vider_points(void);
+
+// sommets du cercle unité, calculés une seule fois au premier dessin
+static double cercle_cos[COTES_CERCLE];
+static double cercle_sin[COTES_CERCLE];
+static bool cercle_initialise = false;
+
+// le nombre de côtés suit le rayon à l'écran, pour des côtés d'environ
+// PIXELS_COTE pixels
 void graphic_cercle(double x, double y, double r, float* couleur, bool plein,
 					double epaisseur)
 {
-	int i;
+	int i, k, pas;
+	double rayon_pixels = r*pixels_par_unite;
+	if(rendu_actif())
+	{
+		rendu_cercle((x - x_min)*pixels_par_unite, (y_max - y)*pixels_par_unite,
+					 rayon_pixels, couleur, plein, epaisseur);
+		return;
+	}
+	if(!cercle_initialise)
+	{
+		for(i = 0; i < COTES_CERCLE; i++)
+		{
+			cercle_cos[i] = cos(2*i*M_PI/COTES_CERCLE);
+			cercle_sin[i] = sin(2*i*M_PI/COTES_CERCLE);
+		}
+		cercle_initialise = true;
+	}
+	if(rayon_pixels < RAYON_POINT)
+	{
+		graphic_point(x, y, couleur);
+		return;
+	}
+	graphic_vider_points();
+	for(k = 0; 2*M_PI*rayon_pixels > COTES_CERCLE/pas_cercle[k]*PIXELS_COTE &&
+			   pas_cercle[k] > 1; k++);
+	pas = pas_cercle[k];
 	glColor3fv(couleur);
 	glLineWidth(epaisseur);	
 	glBegin(plein?GL_POLYGON:GL_LINE_LOOP);
-	for(i =0; i < COTES_CERCLE; i++)
+	for(i =0; i < COTES_CERCLE; i += pas)
 	{
-		glVertex2d(x+r*cos(2*i*M_PI/COTES_CERCLE),
-				   y+r*sin(2*i*M_PI/COTES_CERCLE));
+		glVertex2d(x+r*cercle_cos[i], y+r*cercle_sin[i]);
 	}
 	glEnd();
 }
@@ -37,6 +96,14 @@ void graphic_cercle(double x, double y, double r, float* couleur, bool plein,
 void graphic_segment(double x_a, double y_a, double x_b, double y_b, float *couleur,
 					 double largeur)
 {
+	if(rendu_actif())
+	{
+		rendu_segment((x_a - x_min)*pixels_par_unite, (y_max - y_a)*pixels_par_unite,
+					  (x_b - x_min)*pixels_par_unite, (y_max - y_b)*pixels_par_unite,
+					  couleur, largeur);
+		return;
+	}
+	graphic_vider_points();
 	glColor3fv(couleur);
 	glLineWidth(largeur);
 	glBegin(GL_LINES);
@@ -47,7 +114,8 @@ void graphic_segment(double x_a, double y_a, double x_b, double y_b, float *coul
 
 void graphic_reshape(int largeur, int hauteur)
 {
-	glViewport(0, 0, largeur, hauteur);
+	if(!rendu_actif())
+		glViewport(0, 0, largeur, hauteur);
 	width = largeur;
 	height= hauteur;
 	aspect_ratio = (double)largeur/(double)(hauteur?hauteur:1);
@@ -55,22 +123,34 @@ void graphic_reshape(int largeur, int hauteur)
 
 void graphic_begin_draw(double gauche, double droite, double haut, double bas)
 {
-	glClearColor(1.0, 1.0, 1.0, 0.0);
-	glClear(GL_COLOR_BUFFER_BIT);
-	glLoadIdentity();
+	if(rendu_actif())
+		rendu_debut(couleur_fond);
+	else
+	{
+		glClearColor(couleur_fond[0], couleur_fond[1], couleur_fond[2], 0.0);
+		glClear(GL_COLOR_BUFFER_BIT);
+		glLoadIdentity();
+	}
+	nb_points = 0;
+	double cx = (gauche+droite)/2. + decalage_x;
+	double demi_x = fabs(droite-gauche)/(2.*zoom);
+	double cy = (haut+bas)/2. + decalage_y;
+	double demi_y = fabs(bas-haut)/(2.*zoom);
 	if (aspect_ratio <= 1.)
 	{
-	x_min = -DMAX; x_max = DMAX;
-	y_min = -DMAX/aspect_ratio ;
-	y_max = DMAX/aspect_ratio ;
+	x_min = cx-demi_x; x_max = cx+demi_x;
+	y_min = cy-demi_x/aspect_ratio ;
+	y_max = cy+demi_x/aspect_ratio ;
 	}
 	else
 	{
-	x_min = -DMAX*aspect_ratio;
-	x_max = DMAX*aspect_ratio;
-	y_min = -DMAX ; y_max = DMAX ;
+	x_min = cx-demi_y*aspect_ratio;
+	x_max = cx+demi_y*aspect_ratio;
+	y_min = cy-demi_y ; y_max = cy+demi_y ;
 	}
-	glOrtho(x_min, x_max, y_min, y_max, -1.0, 1.0);
+	if(!rendu_actif())
+		glOrtho(x_min, x_max, y_min, y_max, -1.0, 1.0);
+	pixels_par_unite = width/(double)(x_max - x_min);
 	//int target_x = droite-gauche;
 	//int target_y = bas-haut;
 	//double target_ratio = (double)target_x/target_y;
@@ -86,3 +166,75 @@ void conversion (float x_pos, float y_pos, double* mouse_pos_x, double* mouse_po
 	*mouse_pos_x=((float) x_pos/width)*(x_max - x_min) + x_min;
 	*mouse_pos_y=((float)(height - y_pos)/height)*(y_max - y_min) + y_min;
 }
+
+void graphic_end_draw(void)
+{
+	if(rendu_actif())
+		rendu_fin();
+	else
+		graphic_vider_points();
+}
+
+bool graphic_visible(double x, double y, double r)
+{
+	return x + r >= x_min && x - r <= x_max && y + r >= y_min && y - r <= y_max;
+}
+
+void graphic_limites(double *gauche, double *droite, double *bas, double *haut)
+{
+	*gauche = x_min;
+	*droite = x_max;
+	*bas = y_min;
+	*haut = y_max;
+}
+
+// le point sous le curseur reste immobile: la demi-largeur visible est
+// multipliée par ancien/zoom, le centre se rapproche du point d'autant
+void graphic_zoomer(double facteur, float x_pos, float y_pos)
+{
+	double x, y, ancien = zoom;
+	conversion(x_pos, y_pos, &x, &y);
+	zoom = fmin(ZOOM_MAX, fmax(ZOOM_MIN, zoom*facteur));
+	decalage_x += (x - (x_min + x_max)/2.)*(1. - ancien/zoom);
+	decalage_y += (y - (y_min + y_max)/2.)*(1. - ancien/zoom);
+}
+
+void graphic_deplacer(float dx_pixels, float dy_pixels)
+{
+	decalage_x -= dx_pixels/pixels_par_unite;
+	decalage_y += dy_pixels/pixels_par_unite;
+}
+
+void graphic_vue_initiale(void)
+{
+	zoom = 1.;
+	decalage_x = decalage_y = 0.;
+}
+
+static void graphic_point(double x, double y, float* couleur)
+{
+	if(nb_points && (nb_points == TAILLE_LOT || couleur[0] != couleur_points[0] ||
+					 couleur[1] != couleur_points[1] ||
+					 couleur[2] != couleur_points[2]))
+		graphic_vider_points();
+	couleur_points[0] = couleur[0];
+	couleur_points[1] = couleur[1];
+	couleur_points[2] = couleur[2];
+	lot_points[2*nb_points] = x;
+	lot_points[2*nb_points+1] = y;
+	nb_points++;
+}
+
+static void graphic_vider_points(void)
+{
+	int i;
+	if(!nb_points)
+		return;
+	glColor3fv(couleur_points);
+	glPointSize(TAILLE_POINT);
+	glBegin(GL_POINTS);
+	for(i = 0; i < nb_points; i++)
+		glVertex2fv(&lot_points[2*i]);
+	glEnd();
+	nb_points = 0;
+}
@@ -55,5 +55,46 @@ void graphic_reshape(int largeur, int hauteur);
  * \param bas		La limite basse minimale.
  */
 void graphic_begin_draw(double gauche, double droite, double haut, double bas);
+
+/**
+ * \brief	Termine le dessin commencé par graphic_begin_draw: les cercles trop
+ *			petits pour être vus, dessinés en points par lots, sont envoyés.
+ */
+void graphic_end_draw(void);
+
+/**
+ * \brief	Indique si un cercle touche la partie visible du dernier dessin.
+ * \param x	Coordonnée x du centre.
+ * \param y	Coordonnée y du centre.
+ * \param r	Rayon du cercle.
+ */
+bool graphic_visible(double x, double y, double r);
+
+/**
+ * \brief	Donne les limites de la partie visible du dernier dessin.
+ */
+void graphic_limites(double *gauche, double *droite, double *bas, double *haut);
+
+/**
+ * \brief	Agrandit la vue autour d'un point de la fenêtre, qui reste immobile.
+ *			Prend effet au prochain dessin.
+ * \param facteur	Le facteur d'agrandissement, inférieur à 1 pour réduire.
+ * \param x_pos		Coordonnée x du point, en pixels.
+ * \param y_pos		Coordonnée y du point, en pixels.
+ */
+void graphic_zoomer(double facteur, float x_pos, float y_pos);
+
+/**
+ * \brief	Déplace la vue pour suivre un glissement de la souris.
+ * \param dx_pixels	Le déplacement horizontal de la souris, en pixels.
+ * \param dy_pixels	Le déplacement vertical de la souris, en pixels.
+ */
+void graphic_deplacer(float dx_pixels, float dy_pixels);
+
+/**
+ * \brief	Revient à la vue montrant exactement le rectangle demandé au dessin.
+ */
+void graphic_vue_initiale(void);
+
 void conversion (float x_pos, float y_pos, double* mouse_pos_x, double* mouse_pos_y);
 #endif
@@ -0,0 +1,284 @@
+/*!
+ \file grille.c
+ \brief Module d'index spatial des robots: grille lâche à plusieurs niveaux de
+        rectangles englobants, pour trouver les robots sous un point ou
+        proches d'une zone
+ \author agent
+ \group Sylvain Pellegrini
+		Simon Gilgien
+ \version 1.0
+ \date 19 octobre 2026
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "constantes.h"
+#include "grille.h"
+
+// les cases du niveau n ont un côté TAILLE_CASE*2^n; au-delà du dernier niveau
+// (des millions d'unités) un rectangle pourrait échapper à la recherche
+#define TAILLE_CASE			(4*R_ROBOT)
+#define NB_NIVEAUX			24
+#define CAPACITE_TABLE_MIN	64
+#define CAPACITE_CASE_MIN	4
+#define CAPACITE_IDS_MIN	64
+
+// un rectangle est rangé au plus petit niveau dont le côté des cases dépasse sa
+// plus grande dimension, dans la case de son centre: il ne déborde alors que sur
+// les cases voisines, et un point n'est cherché que dans 3x3 cases par niveau.
+// Les cases sont chaînées dans une table de hachage comme les chunks de
+// particules et libérées dès qu'elles sont vides.
+typedef struct Case CASE;
+struct Case
+{
+	int niveau;
+	int cx;
+	int cy;
+	int nb;
+	int capacite;
+	int *elements;
+	CASE *suivant;
+};
+
+static CASE **table = NULL;
+static int capacite_table = 0;
+static int nb_cases = 0;
+static int nb_par_niveau[NB_NIVEAUX];
+// case de chaque élément et sa place dans la case, pour le retirer en O(1)
+static CASE **case_de = NULL;
+static int *place_de = NULL;
+static int capacite_ids = 0;
+
+static int grille_coord(double x, double taille);
+static CASE** grille_case(int niveau, int cx, int cy);
+static void grille_agrandir_table(void);
+static void grille_reserver(int id);
+static void grille_retirer(int id);
+
+void grille_placer(int id, S2D coin_min, S2D coin_max)
+{
+	int niveau = 0, cx, cy;
+	double taille = TAILLE_CASE;
+	double etendue = fmax(coin_max.x - coin_min.x, coin_max.y - coin_min.y);
+	CASE **p_case, *c;
+
+	while (taille < etendue && niveau < NB_NIVEAUX-1)
+	{
+		taille *= 2;
+		niveau++;
+	}
+	cx = grille_coord((coin_min.x + coin_max.x)/2., taille);
+	cy = grille_coord((coin_min.y + coin_max.y)/2., taille);
+	grille_reserver(id);
+	c = case_de[id];
+	if (c && c->niveau == niveau && c->cx == cx && c->cy == cy)
+		return;
+	grille_retirer(id);
+	if (nb_cases >= capacite_table)
+		grille_agrandir_table();
+	p_case = grille_case(niveau, cx, cy);
+	if (!(c = *p_case))
+	{
+		if (!(c = malloc(sizeof(CASE))))
+			exit(EXIT_FAILURE);
+		c->niveau = niveau;
+		c->cx = cx;
+		c->cy = cy;
+		c->nb = 0;
+		c->capacite = 0;
+		c->elements = NULL;
+		c->suivant = NULL;
+		*p_case = c;
+		nb_cases++;
+	}
+	if (c->nb == c->capacite)
+	{
+		c->capacite = c->capacite ? 2*c->capacite : CAPACITE_CASE_MIN;
+		if (!(c->elements = realloc(c->elements, c->capacite*sizeof(int))))
+			exit(EXIT_FAILURE);
+	}
+	case_de[id] = c;
+	place_de[id] = c->nb;
+	c->elements[c->nb++] = id;
+	nb_par_niveau[niveau]++;
+}
+
+// traiter ne doit pas déplacer d'élément dans la grille
+void grille_parcourir(S2D point, void (*traiter)(int id, void *donnees),
+					  void *donnees)
+{
+	int niveau, cx, cy, dx, dy, k;
+	double taille = TAILLE_CASE;
+	CASE *c;
+
+	if (!nb_cases)
+		return;
+	for (niveau = 0; niveau < NB_NIVEAUX; niveau++, taille *= 2)
+	{
+		if (!nb_par_niveau[niveau])
+			continue;
+		cx = grille_coord(point.x, taille);
+		cy = grille_coord(point.y, taille);
+		for (dx = -1; dx <= 1; dx++)
+		{
+			for (dy = -1; dy <= 1; dy++)
+			{
+				if (!(c = *grille_case(niveau, cx+dx, cy+dy)))
+					continue;
+				for (k = 0; k < c->nb; k++)
+					traiter(c->elements[k], donnees);
+			}
+		}
+	}
+}
+
+// un élément rangé dans la case de son centre déborde d'au plus une demi-case:
+// les cases dont le centre d'un élément touchant la zone peut faire partie
+// entourent la zone d'une demi-case. Si elles sont plus nombreuses que les
+// cases existantes, la table est parcourue.
+void grille_parcourir_zone(S2D coin_min, S2D coin_max,
+						   void (*traiter)(int id, void *donnees), void *donnees)
+{
+	int niveau, cx, cy, cx_min, cx_max, cy_min, cy_max, i, k;
+	double taille = TAILLE_CASE;
+	CASE *c;
+
+	if (!nb_cases)
+		return;
+	for (niveau = 0; niveau < NB_NIVEAUX; niveau++, taille *= 2)
+	{
+		if (!nb_par_niveau[niveau])
+			continue;
+		cx_min = grille_coord(coin_min.x - taille/2., taille);
+		cx_max = grille_coord(coin_max.x + taille/2., taille);
+		cy_min = grille_coord(coin_min.y - taille/2., taille);
+		cy_max = grille_coord(coin_max.y + taille/2., taille);
+		if ((double)(cx_max-cx_min+1)*(cy_max-cy_min+1) > nb_cases)
+		{
+			for (i = 0; i < capacite_table; i++)
+			{
+				for (c = table[i]; c; c = c->suivant)
+				{
+					if (c->niveau != niveau || c->cx < cx_min || c->cx > cx_max ||
+						c->cy < cy_min || c->cy > cy_max)
+						continue;
+					for (k = 0; k < c->nb; k++)
+						traiter(c->elements[k], donnees);
+				}
+			}
+			continue;
+		}
+		for (cx = cx_min; cx <= cx_max; cx++)
+		{
+			for (cy = cy_min; cy <= cy_max; cy++)
+			{
+				if (!(c = *grille_case(niveau, cx, cy)))
+					continue;
+				for (k = 0; k < c->nb; k++)
+					traiter(c->elements[k], donnees);
+			}
+		}
+	}
+}
+
+void grille_vider(void)
+{
+	CASE *c;
+	int i;
+
+	for (i = 0; i < capacite_table; i++)
+	{
+		while ((c = table[i]))
+		{
+			table[i] = c->suivant;
+			free(c->elements);
+			free(c);
+		}
+	}
+	free(table);
+	table = NULL;
+	capacite_table = 0;
+	nb_cases = 0;
+	memset(nb_par_niveau, 0, sizeof(nb_par_niveau));
+	free(case_de);
+	free(place_de);
+	case_de = NULL;
+	place_de = NULL;
+	capacite_ids = 0;
+}
+
+static int grille_coord(double x, double taille)
+{
+	return (int)floor(x/taille);
+}
+
+// case de la table de hachage où est (ou serait) chaînée la case demandée
+static CASE** grille_case(int niveau, int cx, int cy)
+{
+	unsigned int h = ((unsigned int)cx*73856093u ^ (unsigned int)cy*19349663u ^
+					  (unsigned int)niveau*83492791u) & (capacite_table-1);
+	CASE **p_case = &table[h];
+
+	while (*p_case && ((*p_case)->niveau != niveau || (*p_case)->cx != cx ||
+					   (*p_case)->cy != cy))
+		p_case = &(*p_case)->suivant;
+	return p_case;
+}
+
+// double la table quand le nombre de cases dépasse sa capacité
+static void grille_agrandir_table(void)
+{
+	CASE **ancienne = table, *c;
+	int i, ancienne_capacite = capacite_table;
+
+	capacite_table = capacite_table ? 2*capacite_table : CAPACITE_TABLE_MIN;
+	if (!(table = calloc(capacite_table, sizeof(CASE*))))
+		exit(EXIT_FAILURE);
+	for (i = 0; i < ancienne_capacite; i++)
+	{
+		while ((c = ancienne[i]))
+		{
+			ancienne[i] = c->suivant;
+			c->suivant = NULL;
+			*grille_case(c->niveau, c->cx, c->cy) = c;
+		}
+	}
+	free(ancienne);
+}
+
+static void grille_reserver(int id)
+{
+	int ancienne_capacite = capacite_ids;
+
+	if (id < capacite_ids)
+		return;
+	while (capacite_ids <= id)
+		capacite_ids = capacite_ids ? 2*capacite_ids : CAPACITE_IDS_MIN;
+	if (!(case_de = realloc(case_de, capacite_ids*sizeof(CASE*))) ||
+		!(place_de = realloc(place_de, capacite_ids*sizeof(int))))
+		exit(EXIT_FAILURE);
+	memset(&case_de[ancienne_capacite], 0,
+		   (capacite_ids - ancienne_capacite)*sizeof(CASE*));
+}
+
+// le dernier élément de la case prend la place libérée; une case vide est libérée
+static void grille_retirer(int id)
+{
+	CASE *c = case_de[id], **p_case;
+
+	if (!c)
+		return;
+	c->elements[place_de[id]] = c->elements[--c->nb];
+	place_de[c->elements[place_de[id]]] = place_de[id];
+	case_de[id] = NULL;
+	nb_par_niveau[c->niveau]--;
+	if (c->nb == 0)
+	{
+		p_case = grille_case(c->niveau, c->cx, c->cy);
+		*p_case = c->suivant;
+		free(c->elements);
+		free(c);
+		nb_cases--;
+	}
+}
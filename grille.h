@@ -0,0 +1,54 @@
+/*!
+ \file grille.h
+ \brief Module d'index spatial des robots: grille lâche à plusieurs niveaux de
+        rectangles englobants, pour trouver les robots sous un point ou
+        proches d'une zone
+ \author agent
+ \group Sylvain Pellegrini
+		Simon Gilgien
+ \version 1.0
+ \date 19 octobre 2026
+ */
+
+#ifndef GRILLE_H
+#define GRILLE_H
+
+#include "utilitaire.h"
+
+/**
+ * \brief	Range un élément d'après son rectangle englobant, en remplaçant son
+ *			rectangle précédent. Sans effet si la case ne change pas.
+ * \param id		L'identifiant de l'élément, positif.
+ * \param coin_min	Le coin inférieur gauche du rectangle.
+ * \param coin_max	Le coin supérieur droit du rectangle.
+ */
+void grille_placer(int id, S2D coin_min, S2D coin_max);
+
+/**
+ * \brief	Appelle traiter pour chaque élément dont le rectangle peut contenir
+ *			le point; les éléments sont à vérifier par l'appelant.
+ * \param point		Le point cherché.
+ * \param traiter	Fonction recevant l'identifiant de l'élément.
+ * \param donnees	Pointeur transmis tel quel à traiter.
+ */
+void grille_parcourir(S2D point, void (*traiter)(int id, void *donnees),
+					  void *donnees);
+
+/**
+ * \brief	Appelle traiter pour chaque élément dont le rectangle peut toucher la
+ *			zone rectangulaire donnée; les éléments sont à vérifier par
+ *			l'appelant.
+ * \param coin_min	Le coin inférieur gauche de la zone.
+ * \param coin_max	Le coin supérieur droit de la zone.
+ * \param traiter	Fonction recevant l'identifiant de l'élément.
+ * \param donnees	Pointeur transmis tel quel à traiter.
+ */
+void grille_parcourir_zone(S2D coin_min, S2D coin_max,
+						   void (*traiter)(int id, void *donnees), void *donnees);
+
+/**
+ * \brief	Retire tous les éléments et libère la grille.
+ */
+void grille_vider(void);
+
+#endif
@@ -0,0 +1,113 @@
+/*!
+ \file instantane.c
+ \brief Module publiant des images figées de la simulation pour l'affichage,
+        par triple tampon sans verrou entre un producteur et un consommateur
+ \author agent
+ \group Sylvain Pellegrini
+		Simon Gilgien
+ \version 1.0
+ \date 19 octobre 2026
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdatomic.h>
+#include "instantane.h"
+
+#define NB_TAMPONS	3
+#define MASQUE		3
+#define NOUVEAU		4
+
+// chaque tampon appartient à tout instant au producteur, au consommateur ou au
+// milieu; seul l'indice du milieu est partagé, avec un bit signalant une image
+// pas encore reçue. Le rôle de producteur peut changer de fil si la création ou
+// la fin du fil le synchronise avec le précédent.
+static INSTANTANE tampons[NB_TAMPONS];
+static int ecriture = 0;
+static int lecture = 1;
+static atomic_int milieu = 2;
+
+INSTANTANE* instantane_ecriture(void)
+{
+	return &tampons[ecriture];
+}
+
+void instantane_reserver(INSTANTANE *instantane, int nb_robots, int nb_particules)
+{
+	if (nb_robots > instantane->capacite_robots)
+	{
+		if (!(instantane->robots = realloc(instantane->robots,
+										   nb_robots*sizeof(C2D))) ||
+			!(instantane->angles = realloc(instantane->angles,
+										   nb_robots*sizeof(double))) ||
+			!(instantane->manuels = realloc(instantane->manuels,
+											nb_robots*sizeof(bool))))
+			exit(EXIT_FAILURE);
+		instantane->capacite_robots = nb_robots;
+	}
+	if (nb_particules > instantane->capacite_particules)
+	{
+		if (!(instantane->particules = realloc(instantane->particules,
+											   nb_particules*sizeof(C2D))) ||
+			!(instantane->energies = realloc(instantane->energies,
+											 nb_particules*sizeof(double))))
+			exit(EXIT_FAILURE);
+		instantane->capacite_particules = nb_particules;
+	}
+}
+
+void instantane_copier(INSTANTANE *copie, const INSTANTANE *source)
+{
+	instantane_reserver(copie, source->nb_robots, source->nb_particules);
+	copie->tour = source->tour;
+	copie->taux = source->taux;
+	copie->dmax = source->dmax;
+	copie->vitesse_rotation = source->vitesse_rotation;
+	copie->vitesse_translation = source->vitesse_translation;
+	copie->nb_robots = source->nb_robots;
+	copie->nb_particules = source->nb_particules;
+	memcpy(copie->robots, source->robots, source->nb_robots*sizeof(C2D));
+	memcpy(copie->angles, source->angles, source->nb_robots*sizeof(double));
+	memcpy(copie->manuels, source->manuels, source->nb_robots*sizeof(bool));
+	memcpy(copie->particules, source->particules,
+		   source->nb_particules*sizeof(C2D));
+	memcpy(copie->energies, source->energies,
+		   source->nb_particules*sizeof(double));
+}
+
+void instantane_liberer(INSTANTANE *instantane)
+{
+	free(instantane->robots);
+	free(instantane->angles);
+	free(instantane->manuels);
+	free(instantane->particules);
+	free(instantane->energies);
+	*instantane = (INSTANTANE){0};
+}
+
+// la libération publie les écritures du tampon, l'acquisition récupère celles
+// que le consommateur a pu faire avant de le rendre
+void instantane_publier(void)
+{
+	ecriture = atomic_exchange_explicit(&milieu, ecriture | NOUVEAU,
+										memory_order_acq_rel) & MASQUE;
+}
+
+bool instantane_en_attente(void)
+{
+	return atomic_load_explicit(&milieu, memory_order_acquire) & NOUVEAU;
+}
+
+bool instantane_recevoir(void)
+{
+	if (!(atomic_load_explicit(&milieu, memory_order_relaxed) & NOUVEAU))
+		return false;
+	lecture = atomic_exchange_explicit(&milieu, lecture, memory_order_acq_rel)
+			  & MASQUE;
+	return true;
+}
+
+const INSTANTANE* instantane_lecture(void)
+{
+	return &tampons[lecture];
+}
@@ -0,0 +1,92 @@
+/*!
+ \file instantane.h
+ \brief Module publiant des images figées de la simulation pour l'affichage,
+        par triple tampon sans verrou entre un producteur et un consommateur
+ \author agent
+ \group Sylvain Pellegrini
+		Simon Gilgien
+ \version 1.0
+ \date 19 octobre 2026
+ */
+
+#ifndef INSTANTANE_H
+#define INSTANTANE_H
+
+#include <stdbool.h>
+#include "utilitaire.h"
+
+/**
+ * \brief	Image de la simulation à la fin d'un tour. Les couleurs se déduisent
+ *			des indicateurs manuels: une image publiée n'est plus modifiée tant
+ *			que le consommateur la détient.
+ */
+typedef struct Instantane INSTANTANE;
+struct Instantane
+{
+	unsigned int tour;
+	double taux;
+	double dmax;
+	double vitesse_rotation;
+	double vitesse_translation;
+	int nb_robots;
+	int nb_particules;
+	int capacite_robots;
+	int capacite_particules;
+	C2D *robots;
+	double *angles;
+	bool *manuels;
+	C2D *particules;
+	double *energies;
+};
+
+/**
+ * \brief	Retourne le tampon que le producteur remplit avant de le publier.
+ *			Il n'est visible d'aucun autre fil jusqu'à instantane_publier().
+ */
+INSTANTANE* instantane_ecriture(void);
+
+/**
+ * \brief	Agrandit si nécessaire les tableaux d'un tampon d'écriture.
+ * \param nb_robots		Le nombre de robots à contenir.
+ * \param nb_particules	Le nombre de particules à contenir.
+ */
+void instantane_reserver(INSTANTANE *instantane, int nb_robots, int nb_particules);
+
+/**
+ * \brief	Copie une image, par exemple pour l'enregistrer sur un autre fil sans
+ *			retenir le tampon du consommateur.
+ * \param copie		L'image de destination, vide ou déjà remplie.
+ * \param source	L'image à copier.
+ */
+void instantane_copier(INSTANTANE *copie, const INSTANTANE *source);
+
+/**
+ * \brief	Libère les tableaux d'une image qui n'est pas un des tampons.
+ */
+void instantane_liberer(INSTANTANE *instantane);
+
+/**
+ * \brief	Publie le tampon d'écriture, qui devient l'image la plus récente, et
+ *			donne au producteur un nouveau tampon. Un seul échange atomique, sans
+ *			copie ni attente.
+ */
+void instantane_publier(void);
+
+/**
+ * \brief	Indique si la dernière image publiée n'a pas encore été reçue.
+ */
+bool instantane_en_attente(void);
+
+/**
+ * \brief	Prend l'image la plus récente si une nouvelle a été publiée depuis le
+ *			dernier appel. Réservé au consommateur, comme la fonction suivante.
+ * \return	Vrai si l'image du consommateur a changé.
+ */
+bool instantane_recevoir(void);
+
+/**
+ * \brief	Retourne l'image détenue par le consommateur.
+ */
+const INSTANTANE* instantane_lecture(void);
+
+#endif
@@ -13,10 +13,19 @@
 #include <GL/glut.h>
 #include <cstring>
 #include <cstdio>
+#include <atomic>
+#include <pthread.h>
+#include <unistd.h>
 
 extern "C"
 {
 	#include "simulation.h"
+	#include "repartition.h"
+	#include "trajectoire.h"
+	#include "instantane.h"
+	#include "ecriture.h"
+	#include "arene.h"
+	#include "rendu.h"
 	#include "graphic.h"
 	#include "constantes.h"
 }
@@ -25,6 +34,29 @@ extern "C"
 #define CONTROL_MANUEL	1
 #define TAILLE_INITIALE 600
 #define CHAR_MAX		20
+#define NB_TOURS_MAX	10000000
+#define FICHIER_TRAJECTOIRE	"out.trj"
+#define VITESSE_REPLAY_MAX	1000.
+#define NB_COMMANDES		64
+#define ATTENTE_AFFICHAGE	1000
+#define FACTEUR_ZOOM		1.25
+#define MOLETTE_HAUT		3
+#define MOLETTE_BAS			4
+#define TAILLE_IMAGE		800
+
+// action de l'interface sur la simulation, exécutée par le fil qui la possède
+enum Commandes
+{
+	COMMANDE_TOUCHE, COMMANDE_SELECTION, COMMANDE_DESELECTION
+};
+
+typedef struct Commande COMMANDE;
+struct Commande
+{
+	int type;
+	int touche;
+	S2D point;
+};
 
 namespace
 {
@@ -47,12 +79,59 @@ namespace
     GLUI_StaticText *translation;
     GLUI_StaticText *rotation;
     GLUI_Checkbox *recordi;
+    // relecture: la position est fractionnaire pour les vitesses inférieures à
+    // un tour par mise à jour
+    char *filename_replay = NULL;
+    LECTEUR *replay = NULL;
+    bool replay_started = false;
+    double position_replay = 0.;
+    int tour_replay = 0;
+    float vitesse_replay = 1.;
+    GLUI_Button *play_bouton;
+    GLUI_Scrollbar *slider_replay;
+    GLUI_StaticText *cycle_replay;
+    // fil de simulation lancé par Start: il publie une image par tour et ne
+    // calcule le tour suivant qu'une fois la précédente reçue par l'affichage
+    pthread_t simulateur;
+    bool simulateur_lance = false;
+    bool record_simulateur = false;
+    std::atomic<bool> simulateur_arret(false);
+    std::atomic<bool> simulateur_termine(false);
+    // file des commandes de l'interface vers le fil de simulation, à un seul
+    // producteur et un seul consommateur
+    COMMANDE commandes[NB_COMMANDES];
+    std::atomic<unsigned int> tete_commandes(0);
+    std::atomic<unsigned int> queue_commandes(0);
+    // glissement de la vue avec le bouton droit
+    bool glissement = false;
+    int glissement_x, glissement_y;
+    // fil de chargement lancé par Open: il possède la simulation jusqu'à sa fin,
+    // l'affichage garde la dernière image reçue et l'interface ignore les
+    // actions sur la simulation
+    pthread_t chargeur;
+    bool chargement_lance = false;
+    bool relancer_apres_chargement = false;
+    bool chargement_reussi = false;
+    char *fichier_chargement = NULL;
+    std::atomic<bool> chargement_termine(false);
+    std::atomic<int> progression_chargement(0);
+    int progression_affichee = -1;
+    GLUI_StaticText *chargement;
+    // fil d'enregistrement lancé par Save: il écrit une copie de la dernière
+    // image pendant que la simulation continue
+    pthread_t sauveur;
+    bool sauvegarde_lancee = false;
+    bool sauvegarde_reussie = false;
+    char *fichier_sauvegarde = NULL;
+    INSTANTANE sauvegarde = {0};
+    std::atomic<bool> sauvegarde_terminee(false);
 }
 
 enum Widgets
 {
 	BUTTON_OPEN, BUTTON_SAVE, BUTTON_START_STOP, BUTTON_STEP, CHECKBOX_RECORD,
-	CONTROL_MODE
+	CONTROL_MODE, BUTTON_REPLAY, BUTTON_PLAY_PAUSE, SLIDER_REPLAY, SPINNER_SPEED,
+	BUTTON_EXIT
 };
 
 /**
@@ -91,12 +170,126 @@ void main_update_one_step(void);
  */
  void main_create_glui_interface(int GL_window);
 
+/**
+ * \brief	Exécute la simulation sans interface graphique, en mode standard ou
+ *			évènementiel selon la commande, jusqu'à décontamination complète ou
+ *			NB_TOURS_MAX tours
+ * \param trajectoire	Fichier où enregistrer la trajectoire, ou NULL.
+ */
+void main_headless(const char *trajectoire);
+
+/**
+ * \brief	Exécute la simulation sans affichage en écrivant une image tous les
+ *			periode tours avec le rendu logiciel.
+ * \param argc	Nombre d'arguments, 5.
+ * \param argv	"Render", le fichier, le préfixe des images puis la période.
+ */
+int main_render(int argc, char* argv[]);
+
+/**
+ * \brief	Dessine la simulation et écrit l'image du tour donné.
+ */
+void main_image(unsigned int tour);
+
+/**
+ * \brief	Exécute la simulation sans interface graphique, le monde étant
+ *			partagé entre des processus travailleurs locaux, jusqu'à
+ *			décontamination complète ou NB_TOURS_MAX tours
+ * \param argc	Nombre d'arguments, 4.
+ * \param argv	"Shard", le nombre de travailleurs puis le fichier.
+ */
+int main_shard(int argc, char* argv[]);
+
+/**
+ * \brief	Ferme la trajectoire relue, l'affichage revient à la simulation.
+ */
+void main_replay_fermer(void);
+
+/**
+ * \brief	Place la relecture sur un tour et met à jour le curseur et l'affichage.
+ * \param tour	Le tour, inférieur au nombre de tours enregistrés; 0 est l'état
+ *				de départ, et le numéro affiché est celui que le compteur de la
+ *				simulation montrait pour le même état.
+ */
+void main_replay_aller(unsigned int tour);
+
+/**
+ * \brief	Lance le fil de simulation s'il ne tourne pas déjà.
+ */
+void main_simulateur_lancer(void);
+
+/**
+ * \brief	Arrête le fil de simulation et attend sa fin; la simulation revient
+ *			au fil de l'interface, qui peut alors la modifier.
+ * \return	Vrai si le fil tournait.
+ */
+bool main_simulateur_arreter(void);
+
+/**
+ * \brief	Boucle du fil de simulation.
+ */
+void* main_simuler(void *inutilise);
+
+/**
+ * \brief	Arrête la simulation et lance le fil qui lit filename_in; la
+ *			simulation reprend à la fin du chargement si elle tournait.
+ */
+void main_chargement_lancer(void);
+
+/**
+ * \brief	Lit le fichier et prépare la simulation, sur le fil de chargement.
+ */
+void* main_charger(void *inutilise);
+
+/**
+ * \brief	Note la progression du chargement, sur le fil de chargement.
+ */
+void main_chargement_suivre(double fraction);
+
+/**
+ * \brief	Affiche la progression du chargement et, à sa fin, rend la simulation
+ *			à l'interface.
+ */
+void main_chargement_terminer(void);
+
+/**
+ * \brief	Copie la dernière image et lance le fil qui l'écrit dans filename_out.
+ */
+void main_sauvegarde_lancer(void);
+
+/**
+ * \brief	Écrit l'image copiée, sur le fil d'enregistrement.
+ */
+void* main_sauver(void *inutilise);
+
+/**
+ * \brief	Attend la fin de l'enregistrement en cours et en donne le résultat.
+ */
+void main_sauvegarde_terminer(void);
+
+/**
+ * \brief	Transmet une commande au fil de simulation, ou l'exécute aussitôt
+ *			s'il ne tourne pas. Une commande est perdue si la file est pleine.
+ */
+void main_commande(COMMANDE commande);
+
+/**
+ * \brief	Exécute les commandes en attente, sur le fil qui possède la simulation.
+ */
+void main_commandes_executer(void);
+
+/**
+ * \brief	Exécute une commande sur la simulation.
+ */
+void main_commande_executer(const COMMANDE *commande);
+
 /**
  * \brief	Fonction main, parse la ligne de commande
  * \param argc	Nombre d'arguments.
  * \param argv	Arguments de la ligne de commande.
  */
 void mouse_cb (int button, int button_state, int x, int y);
+void main_glisser(int x, int y);
 void processSpecialKeys(int key, int x, int y);
 void afficher_rotation(double vrot);
 void afficher_translation(double vtrans);
@@ -105,6 +298,11 @@ void afficher_turn(int etape);
 
 int main (int argc, char* argv[])
 {	
+	ecriture_set_nb_fils(sysconf(_SC_NPROCESSORS_ONLN));
+	if(argc == 4 && strcmp(argv[1], "Shard") == 0)
+		return main_shard(argc, argv);
+	if(argc == 5 && strcmp(argv[1], "Render") == 0)
+		return main_render(argc, argv);
 	switch(argc)
 	{
 	case 3:
@@ -120,15 +318,111 @@ int main (int argc, char* argv[])
             main_init_gui(&argc, argv);
 			return EXIT_SUCCESS;
 		}
+		if(strcmp(argv[1], "Headless") == 0)
+		{
+			if(simulation_lecture(argv[2]))
+				main_headless(NULL);
+			return EXIT_SUCCESS;
+		}
+		if(strcmp(argv[1], "Events") == 0)
+		{
+			if(simulation_lecture(argv[2]))
+			{
+				simulation_set_evenementiel(true);
+				main_headless(NULL);
+			}
+			return EXIT_SUCCESS;
+		}
+		break;
+	case 4:
+		if(strcmp(argv[1], "Headless") == 0)
+		{
+			if(simulation_lecture(argv[2]))
+				main_headless(argv[3]);
+			return EXIT_SUCCESS;
+		}
 		break;
 	case 1:
         main_init_gui(&argc, argv);
 		return EXIT_SUCCESS;
 	}
-	printf("Usage : %s [{Error|Draw} filename]\n", argv[0]);
+	printf("Usage : %s [{Error|Draw|Headless|Events} filename]\n", argv[0]);
+	printf("        %s Headless filename trajectory\n", argv[0]);
+	printf("        %s Shard nb_workers filename\n", argv[0]);
+	printf("        %s Render filename prefix period\n", argv[0]);
 	return EXIT_FAILURE;
 }
 
+void main_headless(const char *trajectoire)
+{
+	if(trajectoire && !trajectoire_ouvrir(trajectoire, simulation_dmax()))
+		printf("Unable to record the trajectory in %s\n", trajectoire);
+	Td = simulation_executer(NB_TOURS_MAX, &count);
+	trajectoire_fermer();
+	printf("turn %u rate %.3lf\n", count, Td);
+	size_t pic;
+	unsigned long nb_allocations;
+	arene_statistiques(&pic, &nb_allocations);
+	printf("scratch peak %zu bytes, %lu heap calls\n", pic, nb_allocations);
+	unsigned long candidats, arrets, chevauchements;
+	simulation_statistiques_contacts(&candidats, &arrets, &chevauchements);
+	printf("contacts %lu candidates, %lu stops, %lu overlaps left\n",
+		   candidats, arrets, chevauchements);
+	unsigned long blocages, recuperes;
+	simulation_statistiques_blocages(&blocages, &recuperes);
+	printf("stalls %lu detected, %lu recovered\n", blocages, recuperes);
+}
+
+int main_shard(int argc, char* argv[])
+{
+	int nb_travailleurs = atoi(argv[2]);
+	if(nb_travailleurs < 1)
+	{
+		printf("Usage : %s Shard nb_workers filename\n", argv[0]);
+		return EXIT_FAILURE;
+	}
+	if(!simulation_lecture(argv[3]))
+		return EXIT_FAILURE;
+	if(!repartition_executer(nb_travailleurs, NB_TOURS_MAX, &count, &Td))
+	{
+		printf("A worker failed\n");
+		return EXIT_FAILURE;
+	}
+	printf("turn %u rate %.3lf\n", count, Td);
+	return EXIT_SUCCESS;
+}
+
+// les images vont dans prefix_<tour>.ppm, ou brutes sur la sortie standard
+// avec le préfixe "-" pour un encodeur: le bilan est alors écrit sur stderr
+int main_render(int argc, char* argv[])
+{
+	int periode = atoi(argv[4]);
+	if(periode < 1)
+	{
+		printf("Usage : %s Render filename prefix period\n", argv[0]);
+		return EXIT_FAILURE;
+	}
+	if(!simulation_lecture(argv[2]))
+		return EXIT_FAILURE;
+	if(!rendu_ouvrir(TAILLE_IMAGE, TAILLE_IMAGE, sysconf(_SC_NPROCESSORS_ONLN),
+					 argv[3]))
+		return EXIT_FAILURE;
+	graphic_reshape(TAILLE_IMAGE, TAILLE_IMAGE);
+	simulation_set_observateur(periode, main_image);
+	Td = simulation_executer(NB_TOURS_MAX, &count);
+	simulation_set_observateur(0, NULL);
+	rendu_fermer();
+	fprintf(stderr, "turn %u rate %.3lf\n", count, Td);
+	return EXIT_SUCCESS;
+}
+
+void main_image(unsigned int tour)
+{
+	simulation_dessiner();
+	if(!rendu_ecrire(tour))
+		fprintf(stderr, "Unable to write the image of turn %u\n", tour);
+}
+
 void main_init_gui(int *argcp, char **argv)
 {
     glutInit(argcp, argv);
@@ -147,6 +441,7 @@ void main_init_gui(int *argcp, char **argv)
 
 	main_create_glui_interface(view_window); 
 	GLUI_Master.set_glutMouseFunc(mouse_cb);
+	glutMotionFunc(main_glisser);
 	glutSpecialFunc(processSpecialKeys);
 	glutMainLoop();
 }
@@ -155,8 +450,12 @@ void main_create_glui_interface(int GL_window)
 {
 	filename_in  = (char*)malloc(sizeof(GLUI_String));
 	filename_out = (char*)malloc(sizeof(GLUI_String));
+	filename_replay = (char*)malloc(sizeof(GLUI_String));
+	fichier_chargement = (char*)malloc(sizeof(GLUI_String));
+	fichier_sauvegarde = (char*)malloc(sizeof(GLUI_String));
 	*filename_in  = 0;
 	*filename_out = 0;
+	strcpy(filename_replay, FICHIER_TRAJECTOIRE);
 
 	GLUI_Master.set_glutIdleFunc(main_update_one_step);
 	
@@ -166,12 +465,28 @@ void main_create_glui_interface(int GL_window)
 	glui->add_edittext_to_panel(opening, "File name : ", GLUI_EDITTEXT_TEXT,
 								filename_in);
 	open = glui->add_button_to_panel(opening, "Open", BUTTON_OPEN, main_widget_update);
+	chargement = glui->add_statictext_to_panel(opening, "");
 
 	GLUI_Panel *saving = glui->add_panel("Saving");
 	glui->add_edittext_to_panel(saving, "File name : ", GLUI_EDITTEXT_TEXT,
 								filename_out);
 	glui->add_button_to_panel(saving, "Save", BUTTON_SAVE, main_widget_update);
 
+	GLUI_Panel *replaying = glui->add_panel("Replay");
+	glui->add_edittext_to_panel(replaying, "File name : ", GLUI_EDITTEXT_TEXT,
+								filename_replay);
+	glui->add_button_to_panel(replaying, "Replay", BUTTON_REPLAY, main_widget_update);
+	play_bouton = glui->add_button_to_panel(replaying, "Play", BUTTON_PLAY_PAUSE,
+																main_widget_update);
+	slider_replay = new GLUI_Scrollbar(replaying, "Turn", GLUI_SCROLL_HORIZONTAL,
+									   &tour_replay, SLIDER_REPLAY, main_widget_update);
+	slider_replay->set_int_limits(0, 0);
+	GLUI_Spinner *speed = glui->add_spinner_to_panel(replaying, "Speed",
+													 GLUI_SPINNER_FLOAT, &vitesse_replay,
+													 SPINNER_SPEED, main_widget_update);
+	speed->set_float_limits(-VITESSE_REPLAY_MAX, VITESSE_REPLAY_MAX);
+	cycle_replay = glui->add_statictext_to_panel(replaying, "Turn: 0");
+
 	glui->add_column(true);
 	GLUI_Panel *simulation = glui->add_panel("Simulation");
 	start_bouton=glui->add_button_to_panel(simulation, "Start", BUTTON_START_STOP,
@@ -197,41 +512,43 @@ void main_create_glui_interface(int GL_window)
 	translation=glui->add_statictext_to_panel(robot_control, "Translation: 0.000");
 	rotation=glui->add_statictext_to_panel(robot_control, "Rotation: 0.000");
 
-	glui->add_button("Exit", EXIT_SUCCESS, exit);
+	glui->add_button("Exit", BUTTON_EXIT, main_widget_update);
 
 	glui->set_main_gfx_window(GL_window);	
 }
 
 void main_widget_update(int widget)
 {
+	bool relancer;
+
+	// le fil de chargement possède la simulation
+	if(chargement_lance && widget != BUTTON_EXIT)
+		return;
 	switch(widget)
 	{
 	case BUTTON_OPEN:
-		eliminer_tout();
-		simulation_lecture(filename_in);
-        but_initial();
-        simulation_deplacement();
-        // parfois si on ouvre un nouveau fichier la simulation ne commence pas
-		if(glutGetWindow() != view_window)
-			glutSetWindow(view_window);
-		glutPostRedisplay();
+		main_chargement_lancer();
 		break;
 		
 	case BUTTON_SAVE:
-		simulation_ecriture(filename_out);
+		main_sauvegarde_lancer();
 		break;
 		
 	case BUTTON_START_STOP:
 		if(!simulation_started)
 		{
+			main_replay_fermer();
 			simulation_started = true;
+			main_simulateur_lancer();
 			start_bouton-> set_name("Stop");
 			printf("simulation started\n");
 		}
 		else
 		{
 			simulation_started = false;
+			main_simulateur_arreter();
 			recordi->set_int_val(0);
+			trajectoire_fermer();
 			start_bouton-> set_name("Start");
 			printf("simulation stopped\n");
 			
@@ -265,76 +582,287 @@ void main_widget_update(int widget)
 		
 	case CHECKBOX_RECORD:
 		printf("checkbox record changed : reset turn counter\n");
+		relancer = main_simulateur_arreter();
 		count = 0;
 		FILE *fichier;
 		fichier = fopen("out.dat", "w");
 		fichier=NULL;
+		// la trajectoire complète des robots et particules accompagne out.dat
+		if (record)
+			trajectoire_ouvrir(FICHIER_TRAJECTOIRE, simulation_dmax());
+		else
+			trajectoire_fermer();
+		if (relancer)
+			main_simulateur_lancer();
 		break;
 		
 	case CONTROL_MODE:
 		printf("Radiobutton activated: mode changed\n");
+		if (mode == CONTROL_AUTO)
+		{
+			COMMANDE deselection = {COMMANDE_DESELECTION, 0, {0., 0.}};
+			main_commande(deselection);
+		}
+		break;
+
+	case BUTTON_REPLAY:
+		// la simulation en cours est suspendue pendant la relecture
+		if(simulation_started)
+			main_widget_update(BUTTON_START_STOP);
+		main_replay_fermer();
+		if(!(replay = trajectoire_lecteur_ouvrir(filename_replay)) ||
+		   !trajectoire_lecteur_nb_tours(replay))
+		{
+			printf("Unable to replay %s\n", filename_replay);
+			main_replay_fermer();
+			break;
+		}
+		slider_replay->set_int_limits(0, trajectoire_lecteur_nb_tours(replay)-1);
+		main_replay_aller(0);
+		break;
+
+	case BUTTON_PLAY_PAUSE:
+		if(replay && !replay_started)
+		{
+			replay_started = true;
+			play_bouton->set_name("Pause");
+		}
+		else
+		{
+			replay_started = false;
+			play_bouton->set_name("Play");
+		}
 		break;
+
+	case SLIDER_REPLAY:
+		if(replay)
+			main_replay_aller(tour_replay);
+		break;
+
+	case SPINNER_SPEED:
+		break;
+
+	case BUTTON_EXIT:
+		// l'enregistrement est terminé à la sortie, hors du tour en cours
+		if(chargement_lance)
+			pthread_join(chargeur, NULL);
+		main_simulateur_arreter();
+		main_sauvegarde_terminer();
+		exit(EXIT_SUCCESS);
 	}
 }
 
-void main_affichage()
+void main_simulateur_lancer(void)
 {
-	simulation_dessiner();
-	glutSwapBuffers();
+	if(simulateur_lance)
+		return;
+	record_simulateur = record;
+	simulateur_arret = false;
+	simulateur_termine = false;
+	if(pthread_create(&simulateur, NULL, main_simuler, NULL))
+	{
+		printf("Unable to start the simulation thread\n");
+		return;
+	}
+	simulateur_lance = true;
 }
 
-void main_reshape(int w, int h)
+bool main_simulateur_arreter(void)
 {
-	graphic_reshape(w, h);
-	glutPostRedisplay();
+	if(!simulateur_lance)
+		return false;
+	simulateur_arret = true;
+	pthread_join(simulateur, NULL);
+	simulateur_lance = false;
+	main_commandes_executer();
+	return true;
 }
 
-void main_update_one_step(void)
+void* main_simuler(void *inutilise)
 {
-	if (mode== CONTROL_AUTO)
+	while(!simulateur_arret && Td<CENT_POUR_CENT)
 	{
-		deselectionner_tout();
-		glutPostRedisplay();
+		main_commandes_executer();
+		simulation_deplacement();
+		if (count==0)
+		{
+			Si = somme_des_energies();
+		}
+		update_taux_decontamination (&Td, &Si, &Sd);
+		count++;
+		if (record_simulateur)
+		{
+			record_ecriture(count,Td);
+		}
+		simulation_publier(count, Td);
+		// au plus une image d'avance: le tour suivant est calculé pendant que
+		// l'affichage dessine celle-ci
+		while(instantane_en_attente() && !simulateur_arret)
+			usleep(ATTENTE_AFFICHAGE);
+	}
+	simulateur_termine = true;
+	return NULL;
+}
+
+void main_chargement_lancer(void)
+{
+	relancer_apres_chargement = main_simulateur_arreter();
+	// la trajectoire enregistrée ne concerne que la simulation précédente
+	trajectoire_fermer();
+	main_replay_fermer();
+	recordi->set_int_val(0);
+	strcpy(fichier_chargement, filename_in);
+	progression_chargement = 0;
+	progression_affichee = -1;
+	chargement_termine = false;
+	simulation_set_suivi_lecture(main_chargement_suivre);
+	if(pthread_create(&chargeur, NULL, main_charger, NULL))
+	{
+		printf("Unable to start the loading thread\n");
+		simulation_set_suivi_lecture(NULL);
+		return;
+	}
+	chargement_lance = true;
+	open->disable();
+}
+
+void* main_charger(void *inutilise)
+{
+	eliminer_tout();
+	chargement_reussi = simulation_lecture(fichier_chargement);
+	but_initial();
+	simulation_deplacement();
+	// la nouvelle situation apparaît d'un coup, par un seul échange d'image
+	simulation_publier(count, Td);
+	progression_chargement = 100;
+	chargement_termine = true;
+	return NULL;
+}
+
+void main_chargement_suivre(double fraction)
+{
+	progression_chargement = (int)(100*fraction);
+}
+
+void main_chargement_terminer(void)
+{
+	char texte[CHAR_MAX];
+	int progression = progression_chargement;
+
+	if(!chargement_termine)
+	{
+		if(progression != progression_affichee)
+		{
+			progression_affichee = progression;
+			sprintf(texte, "Loading: %d%%", progression);
+			chargement->set_name(texte);
+		}
+		return;
 	}
-	if (simulation_started== true && Td<CENT_POUR_CENT)
+	pthread_join(chargeur, NULL);
+	chargement_lance = false;
+	simulation_set_suivi_lecture(NULL);
+	chargement->set_name(chargement_reussi ? "Loaded" : "Unable to load");
+	open->enable();
+	graphic_vue_initiale();
+	if(relancer_apres_chargement)
+		main_simulateur_lancer();
+	// parfois si on ouvre un nouveau fichier la simulation ne commence pas
+	if(glutGetWindow() != view_window)
+		glutSetWindow(view_window);
+	glutPostRedisplay();
+}
+
+// sans fil de simulation, l'image est d'abord mise à jour comme pour l'affichage
+void main_sauvegarde_lancer(void)
+{
+	if(sauvegarde_lancee)
+	{
+		if(!sauvegarde_terminee)
 		{
-			
-			simulation_deplacement();
-			if (count==0)
-			{
-				Si = somme_des_energies();
-			}
-			update_taux_decontamination (&Td, &Si, &Sd);
-			count++;
-			if (record)
-			{
-				record_ecriture(count,Td);
-				afficher_rate(Td);
-			}
-			
-			afficher_turn(count);
-			afficher_rate(Td);
-			glutSetWindow(view_window);
-			glutPostRedisplay();
+			printf("A save is already in progress\n");
+			return;
 		}
+		main_sauvegarde_terminer();
+	}
+	if(!simulateur_lance)
+	{
+		simulation_publier(count, Td);
+		instantane_recevoir();
+	}
+	instantane_copier(&sauvegarde, instantane_lecture());
+	strcpy(fichier_sauvegarde, filename_out);
+	sauvegarde_terminee = false;
+	if(pthread_create(&sauveur, NULL, main_sauver, NULL))
+	{
+		printf("Unable to start the saving thread\n");
+		return;
+	}
+	sauvegarde_lancee = true;
 }
-void mouse_cb (int button, int button_state, int x, int y)
+
+void* main_sauver(void *inutilise)
 {
-	if (mode==CONTROL_MANUEL && button_state == GLUT_DOWN && button == GLUT_LEFT_BUTTON)
-	{ 	
-		simulation_selectioner_robot(x, y);
+	sauvegarde_reussie = simulation_ecriture_instantane(fichier_sauvegarde,
+														&sauvegarde);
+	sauvegarde_terminee = true;
+	return NULL;
+}
+
+void main_sauvegarde_terminer(void)
+{
+	if(!sauvegarde_lancee)
+		return;
+	pthread_join(sauveur, NULL);
+	sauvegarde_lancee = false;
+	if(sauvegarde_reussie)
+		printf("Saved %s\n", fichier_sauvegarde);
+	else
+		printf("Unable to save %s\n", fichier_sauvegarde);
+}
+
+void main_commande(COMMANDE commande)
+{
+	unsigned int tete = tete_commandes.load(std::memory_order_relaxed);
+
+	if(chargement_lance)
+		return;
+	if(!simulateur_lance)
+	{
+		main_commande_executer(&commande);
+		afficher_rotation(vitesse_angle());
+		afficher_translation(vitesse_transition());
+		glutSetWindow(view_window);
 		glutPostRedisplay();
+		return;
 	}
+	if(tete - queue_commandes.load(std::memory_order_acquire) == NB_COMMANDES)
+		return;
+	commandes[tete % NB_COMMANDES] = commande;
+	tete_commandes.store(tete + 1, std::memory_order_release);
 }
 
-void processSpecialKeys(int key, int x, int y) 
+void main_commandes_executer(void)
 {
-	// les vitesses changent seulement si on clique sur le dessin et pas sur le gui
-	for (int i=0; i<simulation_nombre_robot(); i++)
+	unsigned int queue = queue_commandes.load(std::memory_order_relaxed);
+
+	while(queue != tete_commandes.load(std::memory_order_acquire))
 	{
-		if (manual_robot(i))
+		main_commande_executer(&commandes[queue % NB_COMMANDES]);
+		queue_commandes.store(++queue, std::memory_order_release);
+	}
+}
+
+void main_commande_executer(const COMMANDE *commande)
+{
+	switch(commande->type)
+	{
+	case COMMANDE_TOUCHE:
+		for (int k=0; k<simulation_nb_manuels(); k++)
 		{
-			switch(key)
+			int i = simulation_robot_manuel(k);
+
+			switch(commande->touche)
 			{
 				case GLUT_KEY_LEFT:
 					simulation_ajouter_vitesse_rotation(i);
@@ -349,14 +877,165 @@ void processSpecialKeys(int key, int x, int y)
 					simulation_soustraire_vitesse_translation(i);
 					break;
 			}
+		}
+		break;
 
-		afficher_rotation(vitesse_angle());
-		afficher_translation(vitesse_transition());
-		glutSetWindow(view_window);
-		glutPostRedisplay();	
+	case COMMANDE_SELECTION:
+		simulation_selectioner_point(commande->point);
+		break;
+
+	case COMMANDE_DESELECTION:
+		deselectionner_tout();
+		break;
+	}
+}
+
+void main_replay_fermer(void)
+{
+	if(!replay)
+		return;
+	trajectoire_lecteur_fermer(replay);
+	replay = NULL;
+	replay_started = false;
+	play_bouton->set_name("Play");
+	slider_replay->set_int_limits(0, 0);
+	glutSetWindow(view_window);
+	glutPostRedisplay();
+}
+
+void main_replay_aller(unsigned int tour)
+{
+	char texte[CHAR_MAX];
+
+	// le lecteur ne rejoue que le bloc contenant le tour: le déplacement est
+	// immédiat dans les deux sens. Le compteur est remis à 0 quand
+	// l'enregistrement commence, et le tour 0 du fichier est cet état: le
+	// numéro affiché est donc celui de la simulation.
+	if(!trajectoire_lecteur_aller(replay, tour))
+		return;
+	position_replay = tour;
+	tour_replay = tour;
+	slider_replay->set_int_val(tour);
+	sprintf(texte, "Turn: %u", tour);
+	cycle_replay->set_name(texte);
+	glutSetWindow(view_window);
+	glutPostRedisplay();
+}
+
+void main_affichage()
+{
+	if(replay)
+		simulation_dessiner_replay(replay);
+	else
+	{
+		// sans fil de simulation ni de chargement, l'interface possède l'état et
+		// publie elle-même
+		if(!simulateur_lance && !chargement_lance)
+		{
+			simulation_publier(count, Td);
+			instantane_recevoir();
+		}
+		simulation_dessiner_instantane(instantane_lecture());
+	}
+	glutSwapBuffers();
+}
+
+void main_reshape(int w, int h)
+{
+	graphic_reshape(w, h);
+	glutPostRedisplay();
+}
+
+void main_update_one_step(void)
+{
+	if (chargement_lance)
+		main_chargement_terminer();
+	if (sauvegarde_lancee && sauvegarde_terminee)
+		main_sauvegarde_terminer();
+	if (simulateur_lance)
+	{
+		if (simulateur_termine)
+		{
+			main_simulateur_arreter();
+			glutSetWindow(view_window);
+			glutPostRedisplay();
+		}
+		else if (instantane_recevoir())
+		{
+			const INSTANTANE *instantane = instantane_lecture();
+			afficher_turn(instantane->tour);
+			afficher_rate(instantane->taux);
+			afficher_rotation(instantane->vitesse_rotation);
+			afficher_translation(instantane->vitesse_translation);
+			glutSetWindow(view_window);
+			glutPostRedisplay();
+		}
+	}
+	if (replay && replay_started)
+	{
+		// la vitesse est en tours par mise à jour, négative pour revenir en arrière;
+		// la lecture s'arrête aux extrémités
+		double dernier = trajectoire_lecteur_nb_tours(replay) - 1;
+		position_replay += vitesse_replay;
+		if (position_replay <= 0. || position_replay >= dernier)
+		{
+			position_replay = position_replay <= 0. ? 0. : dernier;
+			main_widget_update(BUTTON_PLAY_PAUSE);
+		}
+		if ((int)position_replay != tour_replay)
+		{
+			double position = position_replay;
+			main_replay_aller((unsigned int)position);
+			position_replay = position;
 		}
 	}
 }
+void mouse_cb (int button, int button_state, int x, int y)
+{
+	if (mode==CONTROL_MANUEL && button_state == GLUT_DOWN && button == GLUT_LEFT_BUTTON)
+	{ 	
+		// la conversion dépend du dernier dessin, fait sur ce fil
+		COMMANDE selection = {COMMANDE_SELECTION, 0, {0., 0.}};
+		utilitaire_conversion(x, y, &selection.point.x, &selection.point.y);
+		main_commande(selection);
+	}
+	// la molette agrandit autour du curseur, le bouton droit fait glisser la vue
+	if (button_state == GLUT_DOWN && (button == MOLETTE_HAUT || button == MOLETTE_BAS))
+	{
+		graphic_zoomer(button == MOLETTE_HAUT ? FACTEUR_ZOOM : 1./FACTEUR_ZOOM, x, y);
+		glutPostRedisplay();
+	}
+	if (button == GLUT_RIGHT_BUTTON)
+	{
+		glissement = button_state == GLUT_DOWN;
+		glissement_x = x;
+		glissement_y = y;
+	}
+}
+
+void main_glisser(int x, int y)
+{
+	if (!glissement)
+		return;
+	graphic_deplacer(x - glissement_x, y - glissement_y);
+	glissement_x = x;
+	glissement_y = y;
+	glutPostRedisplay();
+}
+
+void processSpecialKeys(int key, int x, int y) 
+{
+	// Home revient à la vue entière du monde
+	if (key == GLUT_KEY_HOME)
+	{
+		graphic_vue_initiale();
+		glutPostRedisplay();
+		return;
+	}
+	// les vitesses changent seulement si on clique sur le dessin et pas sur le gui
+	COMMANDE touche = {COMMANDE_TOUCHE, key, {0., 0.}};
+	main_commande(touche);
+}
 
 void afficher_rotation(double vrot)
 {
@@ -0,0 +1,521 @@
+/*!
+ \file navigation.c
+ \brief Module de navigation: champs de distance partagés par les robots qui
+        visent une même particule, pour contourner les autres particules
+ \author agent
+ \group Sylvain Pellegrini
+		Simon Gilgien
+ \version 1.0
+ \date 19 octobre 2026
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "constantes.h"
+#include "particule.h"
+#include "navigation.h"
+
+// le côté des cases est doublé tant que la zone dépasse NB_CASES_MAX cases
+#define TAILLE_CASE			R_ROBOT
+#define NB_CASES_MAX		(1 << 16)
+#define MARGE				(4*R_ROBOT)
+#define SANS_PIVOT			-1
+#define CAPACITE_CHAMPS_MIN	8
+
+// un champ couvre une zone autour d'une cible et des robots qui la visent. Chaque
+// case libre retient la longueur du plus court chemin jusqu'au contact de la
+// cible et son pivot: la case la plus lointaine du chemin visible depuis elle,
+// ou SANS_PIVOT si la cible elle-même est en vue. Une case est bloquée si un
+// robot centré sur elle toucherait une autre particule. L'empreinte résume les
+// particules qui bloquent des cases, pour reconnaître un champ encore valable
+// après une renumérotation des particules.
+typedef struct Champ CHAMP;
+struct Champ
+{
+	int cible;
+	C2D cercle;
+	S2D origine;
+	double taille;
+	int nx;
+	int ny;
+	unsigned long long empreinte;
+	bool utilise;
+	float *distance;
+	int *pivot;
+	bool *bloquee;
+};
+
+typedef struct Empreinte EMPREINTE;
+struct Empreinte
+{
+	int cible;
+	unsigned long long somme;
+};
+
+// tas binaire de Dijkstra; une case déjà fixée est ignorée quand elle ressort
+typedef struct Noeud NOEUD;
+struct Noeud
+{
+	float distance;
+	int place;
+};
+
+static CHAMP *champs = NULL;
+static int nb_champs = 0;
+static int capacite_champs = 0;
+// champ de chaque particule, -1 sans champ
+static int *champ_de = NULL;
+static int capacite_champ_de = 0;
+// cases dont la distance est fixée, pour la construction en cours
+static bool *fermees = NULL;
+static int capacite_fermees = 0;
+static NOEUD *tas = NULL;
+static int taille_tas = 0;
+static int capacite_tas = 0;
+
+static CHAMP* navigation_champ(int cible, C2D cercle);
+static CHAMP* navigation_reprendre(int cible, C2D cercle, S2D coin_min,
+								   S2D coin_max);
+static void navigation_zone(const CHAMP *champ, S2D *p_coin_min, S2D *p_coin_max);
+static void navigation_empreinte(int indice, C2D cercle, void *donnees);
+static unsigned long long navigation_signer(C2D cercle);
+static unsigned long long navigation_melanger(double x);
+static void navigation_bloquer(int indice, C2D cercle, void *donnees);
+static S2D navigation_centre(const CHAMP *champ, int place);
+static bool navigation_visible(const CHAMP *champ, S2D depart, S2D arrivee,
+							   double rayon_arrivee);
+static int navigation_voisine(const CHAMP *champ, int place, int k);
+static void navigation_verifier(CHAMP *champ, int place);
+static void navigation_relacher(CHAMP *champ, int place, int voisine);
+static void navigation_empiler(float distance, int place);
+static NOEUD navigation_depiler(void);
+
+void navigation_construire(int cible, C2D cercle, S2D coin_min, S2D coin_max)
+{
+	CHAMP *champ;
+	NOEUD noeud;
+	S2D centre, zone_min, zone_max;
+	double portee = cercle.rayon + R_ROBOT;
+	int k, place, voisine, nb_cases;
+
+	if (cible >= capacite_champ_de)
+	{
+		k = capacite_champ_de;
+		while (capacite_champ_de <= cible)
+			capacite_champ_de = capacite_champ_de ? 2*capacite_champ_de : 64;
+		if (!(champ_de = realloc(champ_de, capacite_champ_de*sizeof(int))))
+			exit(EXIT_FAILURE);
+		memset(&champ_de[k], -1, (capacite_champ_de - k)*sizeof(int));
+	}
+	champ_de[cible] = -1;
+	if ((champ = navigation_reprendre(cible, cercle, coin_min, coin_max)))
+	{
+		champ->cible = cible;
+		champ->utilise = true;
+		champ_de[cible] = champ - champs;
+		return;
+	}
+	if (nb_champs == capacite_champs)
+	{
+		capacite_champs = capacite_champs ? 2*capacite_champs :
+						  CAPACITE_CHAMPS_MIN;
+		if (!(champs = realloc(champs, capacite_champs*sizeof(CHAMP))))
+			exit(EXIT_FAILURE);
+	}
+	champ_de[cible] = nb_champs;
+	champs[nb_champs++] = (CHAMP){0, {{0., 0.}, 0.}, {0., 0.}, 0., 0, 0, 0, true,
+								  NULL, NULL, NULL};
+	champ = &champs[champ_de[cible]];
+	champ->cible = cible;
+	champ->cercle = cercle;
+	champ->origine.x = fmin(coin_min.x, cercle.centre.x - portee) - MARGE;
+	champ->origine.y = fmin(coin_min.y, cercle.centre.y - portee) - MARGE;
+	zone_max.x = fmax(coin_max.x, cercle.centre.x + portee) + MARGE;
+	zone_max.y = fmax(coin_max.y, cercle.centre.y + portee) + MARGE;
+	champ->taille = TAILLE_CASE;
+	do
+	{
+		champ->nx = (int)ceil((zone_max.x - champ->origine.x)/champ->taille);
+		champ->ny = (int)ceil((zone_max.y - champ->origine.y)/champ->taille);
+		if ((double)champ->nx*champ->ny > NB_CASES_MAX)
+			champ->taille *= 2;
+	} while ((double)champ->nx*champ->ny > NB_CASES_MAX);
+	nb_cases = champ->nx*champ->ny;
+	if (!(champ->distance = realloc(champ->distance, nb_cases*sizeof(float))) ||
+		!(champ->pivot = realloc(champ->pivot, nb_cases*sizeof(int))) ||
+		!(champ->bloquee = realloc(champ->bloquee, nb_cases*sizeof(bool))))
+		exit(EXIT_FAILURE);
+	memset(champ->bloquee, 0, nb_cases*sizeof(bool));
+	navigation_zone(champ, &zone_min, &zone_max);
+	particule_parcourir_zone(zone_min, zone_max, navigation_bloquer, champ);
+	// les cases au contact de la cible sont les sources
+	taille_tas = 0;
+	for (place = 0; place < nb_cases; place++)
+	{
+		champ->distance[place] = INFINITY;
+		champ->pivot[place] = SANS_PIVOT;
+		if (champ->bloquee[place])
+			continue;
+		centre = navigation_centre(champ, place);
+		if (util_distance(centre, cercle.centre) <= portee + champ->taille)
+		{
+			champ->distance[place] = util_distance(centre, cercle.centre);
+			navigation_empiler(champ->distance[place], place);
+		}
+	}
+	if (nb_cases > capacite_fermees)
+	{
+		capacite_fermees = nb_cases;
+		if (!(fermees = realloc(fermees, capacite_fermees*sizeof(bool))))
+			exit(EXIT_FAILURE);
+	}
+	memset(fermees, 0, nb_cases*sizeof(bool));
+	while (taille_tas)
+	{
+		noeud = navigation_depiler();
+		if (fermees[noeud.place])
+			continue;
+		fermees[noeud.place] = true;
+		if (util_distance(navigation_centre(champ, noeud.place), cercle.centre) >
+			portee + champ->taille)
+			navigation_verifier(champ, noeud.place);
+		for (k = 0; k < 8; k++)
+		{
+			if ((voisine = navigation_voisine(champ, noeud.place, k)) >= 0 &&
+				!fermees[voisine])
+				navigation_relacher(champ, noeud.place, voisine);
+		}
+	}
+}
+
+void navigation_commencer(void)
+{
+	int k;
+
+	for (k = 0; k < nb_champs; k++)
+	{
+		champs[k].utilise = false;
+		champ_de[champs[k].cible] = -1;
+	}
+}
+
+void navigation_terminer(void)
+{
+	int k, n = 0;
+
+	for (k = 0; k < nb_champs; k++)
+	{
+		if (!champs[k].utilise)
+		{
+			free(champs[k].distance);
+			free(champs[k].pivot);
+			free(champs[k].bloquee);
+			continue;
+		}
+		champs[n] = champs[k];
+		champ_de[champs[n].cible] = n;
+		n++;
+	}
+	nb_champs = n;
+}
+
+bool navigation_couvre(int cible, C2D cercle)
+{
+	return navigation_champ(cible, cercle) != NULL;
+}
+
+bool navigation_but(int cible, C2D cercle, S2D point, S2D *p_but)
+{
+	CHAMP *champ = navigation_champ(cible, cercle);
+	int cx, cy, place;
+
+	if (!champ)
+		return false;
+	cx = (int)floor((point.x - champ->origine.x)/champ->taille);
+	cy = (int)floor((point.y - champ->origine.y)/champ->taille);
+	if (cx < 0 || cx >= champ->nx || cy < 0 || cy >= champ->ny)
+		return false;
+	place = cy*champ->nx + cx;
+	if (champ->distance[place] == INFINITY || champ->pivot[place] == SANS_PIVOT)
+		return false;
+	*p_but = navigation_centre(champ, champ->pivot[place]);
+	return true;
+}
+
+void navigation_vider(void)
+{
+	int k;
+
+	for (k = 0; k < nb_champs; k++)
+	{
+		free(champs[k].distance);
+		free(champs[k].pivot);
+		free(champs[k].bloquee);
+	}
+	free(champs);
+	champs = NULL;
+	nb_champs = 0;
+	capacite_champs = 0;
+	free(champ_de);
+	champ_de = NULL;
+	capacite_champ_de = 0;
+	free(fermees);
+	fermees = NULL;
+	capacite_fermees = 0;
+	free(tas);
+	tas = NULL;
+	taille_tas = 0;
+	capacite_tas = 0;
+}
+
+// un champ construit pour une autre position de la particule est périmé
+static CHAMP* navigation_champ(int cible, C2D cercle)
+{
+	CHAMP *champ;
+
+	if (cible < 0 || cible >= capacite_champ_de || champ_de[cible] < 0)
+		return NULL;
+	champ = &champs[champ_de[cible]];
+	if (champ->cercle.centre.x != cercle.centre.x ||
+		champ->cercle.centre.y != cercle.centre.y ||
+		champ->cercle.rayon != cercle.rayon)
+		return NULL;
+	return champ;
+}
+
+// un champ inutilisé de la même particule est repris si sa zone couvre encore la
+// cible et ses robots et si les particules qui la touchent n'ont pas changé
+static CHAMP* navigation_reprendre(int cible, C2D cercle, S2D coin_min,
+								   S2D coin_max)
+{
+	EMPREINTE empreinte;
+	S2D zone_min, zone_max;
+	double portee = cercle.rayon + R_ROBOT;
+	int k;
+
+	for (k = 0; k < nb_champs; k++)
+	{
+		if (champs[k].utilise || champs[k].cercle.centre.x != cercle.centre.x ||
+			champs[k].cercle.centre.y != cercle.centre.y ||
+			champs[k].cercle.rayon != cercle.rayon)
+			continue;
+		navigation_zone(&champs[k], &zone_min, &zone_max);
+		if (fmin(coin_min.x, cercle.centre.x - portee) < zone_min.x + R_ROBOT ||
+			fmin(coin_min.y, cercle.centre.y - portee) < zone_min.y + R_ROBOT ||
+			fmax(coin_max.x, cercle.centre.x + portee) > zone_max.x - R_ROBOT ||
+			fmax(coin_max.y, cercle.centre.y + portee) > zone_max.y - R_ROBOT)
+			continue;
+		empreinte = (EMPREINTE){cible, 0};
+		particule_parcourir_zone(zone_min, zone_max, navigation_empreinte,
+								 &empreinte);
+		if (empreinte.somme == champs[k].empreinte)
+			return &champs[k];
+	}
+	return NULL;
+}
+
+// zone des particules pouvant bloquer une case du champ
+static void navigation_zone(const CHAMP *champ, S2D *p_coin_min, S2D *p_coin_max)
+{
+	p_coin_min->x = champ->origine.x - R_ROBOT;
+	p_coin_min->y = champ->origine.y - R_ROBOT;
+	p_coin_max->x = champ->origine.x + champ->nx*champ->taille + R_ROBOT;
+	p_coin_max->y = champ->origine.y + champ->ny*champ->taille + R_ROBOT;
+}
+
+// somme indépendante de l'ordre de parcours des particules autres que la cible
+static void navigation_empreinte(int indice, C2D cercle, void *donnees)
+{
+	EMPREINTE *empreinte = donnees;
+
+	if (indice != empreinte->cible)
+		empreinte->somme += navigation_signer(cercle);
+}
+
+static unsigned long long navigation_signer(C2D cercle)
+{
+	return navigation_melanger(cercle.centre.x) ^
+		   (navigation_melanger(cercle.centre.y) << 1) ^
+		   (navigation_melanger(cercle.rayon) << 2);
+}
+
+static unsigned long long navigation_melanger(double x)
+{
+	unsigned long long h;
+
+	memcpy(&h, &x, sizeof(h));
+	h ^= h >> 33;
+	h *= 0xff51afd7ed558ccdULL;
+	h ^= h >> 33;
+	h *= 0xc4ceb9fe1a85ec53ULL;
+	h ^= h >> 33;
+	return h;
+}
+
+// bloque les cases dont le centre est à moins de R_ROBOT de la particule et
+// ajoute la particule à l'empreinte du champ
+static void navigation_bloquer(int indice, C2D cercle, void *donnees)
+{
+	CHAMP *champ = donnees;
+	double portee = cercle.rayon + R_ROBOT;
+	int cx, cy, cx_min, cx_max, cy_min, cy_max;
+
+	if (indice == champ->cible)
+		return;
+	champ->empreinte += navigation_signer(cercle);
+	cx_min = (int)floor((cercle.centre.x - portee - champ->origine.x)/champ->taille);
+	cx_max = (int)floor((cercle.centre.x + portee - champ->origine.x)/champ->taille);
+	cy_min = (int)floor((cercle.centre.y - portee - champ->origine.y)/champ->taille);
+	cy_max = (int)floor((cercle.centre.y + portee - champ->origine.y)/champ->taille);
+	cx_min = cx_min < 0 ? 0 : cx_min;
+	cy_min = cy_min < 0 ? 0 : cy_min;
+	cx_max = cx_max >= champ->nx ? champ->nx-1 : cx_max;
+	cy_max = cy_max >= champ->ny ? champ->ny-1 : cy_max;
+	for (cy = cy_min; cy <= cy_max; cy++)
+	{
+		for (cx = cx_min; cx <= cx_max; cx++)
+		{
+			if (util_distance(navigation_centre(champ, cy*champ->nx + cx),
+							  cercle.centre) < portee)
+				champ->bloquee[cy*champ->nx + cx] = true;
+		}
+	}
+}
+
+static S2D navigation_centre(const CHAMP *champ, int place)
+{
+	S2D centre = {champ->origine.x + (place % champ->nx + 0.5)*champ->taille,
+				  champ->origine.y + (place / champ->nx + 0.5)*champ->taille};
+	return centre;
+}
+
+// le segment est échantillonné tous les demi-côtés de case et s'arrête à
+// rayon_arrivee de son extrémité; il est masqué s'il passe par une case bloquée
+// ou sort du champ
+static bool navigation_visible(const CHAMP *champ, S2D depart, S2D arrivee,
+							   double rayon_arrivee)
+{
+	double longueur = util_distance(depart, arrivee) - rayon_arrivee;
+	double pas = champ->taille/2., s, x, y;
+	int cx, cy;
+
+	for (s = pas; s < longueur; s += pas)
+	{
+		x = depart.x + (arrivee.x - depart.x)*s/(longueur + rayon_arrivee);
+		y = depart.y + (arrivee.y - depart.y)*s/(longueur + rayon_arrivee);
+		cx = (int)floor((x - champ->origine.x)/champ->taille);
+		cy = (int)floor((y - champ->origine.y)/champ->taille);
+		if (cx < 0 || cx >= champ->nx || cy < 0 || cy >= champ->ny ||
+			champ->bloquee[cy*champ->nx + cx])
+			return false;
+	}
+	return true;
+}
+
+// k-ième des 8 voisines de la case, ou -1 si elle est bloquée, hors du champ,
+// ou en diagonale entre deux cases bloquées
+static int navigation_voisine(const CHAMP *champ, int place, int k)
+{
+	static const int dx[8] = {1, -1, 0, 0, 1, 1, -1, -1};
+	static const int dy[8] = {0, 0, 1, -1, 1, -1, 1, -1};
+	int cx = place % champ->nx, cy = place / champ->nx;
+	int vx = cx + dx[k], vy = cy + dy[k];
+
+	if (vx < 0 || vx >= champ->nx || vy < 0 || vy >= champ->ny ||
+		champ->bloquee[vy*champ->nx + vx])
+		return -1;
+	if (dx[k] && dy[k] && (champ->bloquee[cy*champ->nx + vx] ||
+						   champ->bloquee[vy*champ->nx + cx]))
+		return -1;
+	return vy*champ->nx + vx;
+}
+
+// comme Lazy Theta*: la vue sur le pivot supposée par navigation_relacher n'est
+// contrôlée qu'à la fixation de la case. Si elle manque, la case passe par la
+// voisine déjà fixée la plus proche de la cible
+static void navigation_verifier(CHAMP *champ, int place)
+{
+	S2D centre = navigation_centre(champ, place);
+	float distance;
+	int k, voisine;
+
+	if (champ->pivot[place] == SANS_PIVOT ?
+		navigation_visible(champ, centre, champ->cercle.centre,
+						   champ->cercle.rayon + R_ROBOT) :
+		navigation_visible(champ, centre,
+						   navigation_centre(champ, champ->pivot[place]), 0.))
+		return;
+	champ->distance[place] = INFINITY;
+	for (k = 0; k < 8; k++)
+	{
+		if ((voisine = navigation_voisine(champ, place, k)) < 0 ||
+			!fermees[voisine])
+			continue;
+		distance = champ->distance[voisine] +
+				   util_distance(centre, navigation_centre(champ, voisine));
+		if (distance < champ->distance[place])
+		{
+			champ->distance[place] = distance;
+			champ->pivot[place] = voisine;
+		}
+	}
+}
+
+// la voisine reprend le pivot de la case, ou vise la cible si la case la vise
+static void navigation_relacher(CHAMP *champ, int place, int voisine)
+{
+	S2D depart = navigation_centre(champ, voisine);
+	int pivot = champ->pivot[place];
+	float distance;
+
+	if (champ->distance[place] == INFINITY)
+		return;
+	if (pivot == SANS_PIVOT)
+		distance = util_distance(depart, champ->cercle.centre);
+	else
+		distance = champ->distance[pivot] +
+				   util_distance(depart, navigation_centre(champ, pivot));
+	if (distance >= champ->distance[voisine])
+		return;
+	champ->distance[voisine] = distance;
+	champ->pivot[voisine] = pivot;
+	navigation_empiler(distance, voisine);
+}
+
+static void navigation_empiler(float distance, int place)
+{
+	int k = taille_tas++, parent;
+
+	if (taille_tas > capacite_tas)
+	{
+		capacite_tas = capacite_tas ? 2*capacite_tas : 64;
+		if (!(tas = realloc(tas, capacite_tas*sizeof(NOEUD))))
+			exit(EXIT_FAILURE);
+	}
+	while (k > 0 && tas[parent = (k-1)/2].distance > distance)
+	{
+		tas[k] = tas[parent];
+		k = parent;
+	}
+	tas[k] = (NOEUD){distance, place};
+}
+
+static NOEUD navigation_depiler(void)
+{
+	NOEUD sommet = tas[0], dernier = tas[--taille_tas];
+	int k = 0, enfant;
+
+	while ((enfant = 2*k+1) < taille_tas)
+	{
+		if (enfant+1 < taille_tas && tas[enfant+1].distance < tas[enfant].distance)
+			enfant++;
+		if (tas[enfant].distance >= dernier.distance)
+			break;
+		tas[k] = tas[enfant];
+		k = enfant;
+	}
+	tas[k] = dernier;
+	return sommet;
+}
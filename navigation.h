@@ -0,0 +1,67 @@
+/*!
+ \file navigation.h
+ \brief Module de navigation: champs de distance partagés par les robots qui
+        visent une même particule, pour contourner les autres particules
+ \author agent
+ \group Sylvain Pellegrini
+		Simon Gilgien
+ \version 1.0
+ \date 19 octobre 2026
+ */
+
+#ifndef NAVIGATION_H
+#define NAVIGATION_H
+
+#include <stdbool.h>
+#include "utilitaire.h"
+
+/**
+ * \brief	Met de côté les champs existants avant une nouvelle attribution des
+ *			buts: ils ne couvrent plus aucune particule jusqu'à ce qu'un appel à
+ *			navigation_construire les reprenne.
+ */
+void navigation_commencer(void);
+
+/**
+ * \brief	Donne un champ à une particule cible sur une zone rectangulaire
+ *			élargie d'une marge; les autres particules de la zone sont des
+ *			obstacles. Un champ mis de côté est repris si la particule, sa zone
+ *			et ses obstacles n'ont pas changé, et sinon un champ est construit.
+ * \param cible		L'indice de la particule, positif.
+ * \param cercle	La position de la particule.
+ * \param coin_min	Le coin inférieur gauche de la zone.
+ * \param coin_max	Le coin supérieur droit de la zone.
+ */
+void navigation_construire(int cible, C2D cercle, S2D coin_min, S2D coin_max);
+
+/**
+ * \brief	Libère les champs mis de côté qui n'ont pas été repris.
+ */
+void navigation_terminer(void);
+
+/**
+ * \brief	Indique si la particule a un champ, construit quand elle était à la
+ *			position donnée.
+ * \param cible		L'indice de la particule.
+ * \param cercle	La position actuelle de la particule.
+ */
+bool navigation_couvre(int cible, C2D cercle);
+
+/**
+ * \brief	Donne en O(1) le point de passage d'un robot vers sa cible, visible
+ *			depuis sa case sans toucher d'obstacle.
+ * \param cible		L'indice de la particule visée.
+ * \param cercle	La position actuelle de la particule.
+ * \param point		Le centre du robot.
+ * \param p_but		Reçoit le point de passage.
+ * \return	Faux si la cible est en vue directe ou hors du champ; le robot
+ *			va alors droit sur elle.
+ */
+bool navigation_but(int cible, C2D cercle, S2D point, S2D *p_but);
+
+/**
+ * \brief	Retire tous les champs et libère leur mémoire.
+ */
+void navigation_vider(void);
+
+#endif
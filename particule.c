@@ -1,7 +1,7 @@
 /*!
  \file particule.c
  \brief Module contenant le type opaque particule
-        implementation avec une liste
+        implementation avec des tableaux compacts
  \author Simon Gilgien
  \group Sylvain Pellegrini
 		Simon Gilgien
@@ -13,25 +13,143 @@
 #include <stdio.h>
 #include <assert.h>
 #include <stdlib.h>
+#include <string.h>
+#include <math.h>
 #include "error.h"
 #include "particule.h"
+#include "trajectoire.h"
+#include "echeancier.h"
+#include "ecriture.h"
 #include "constantes.h"
 
 #define EPAISSEUR_TRAIT_PARTICULE		1
+// un chunk couvre un carré de ce côté; le centre d'une particule qui touche un
+// point est donc au plus dans le chunk voisin
+#define TAILLE_CHUNK					(2*R_PARTICULE_MAX)
+#define CAPACITE_TABLE_MIN				64
+#define CAPACITE_CHUNK_MIN				4
+#define CAPACITE_CLASSES_MIN			8
+#define CAPACITE_MEMBRES_MIN			16
+#define CAPACITE_VOISINES_MIN			16
+#define CAPACITE_PARTICULES_MIN			64
+#define NB_ENFANTS						4
+// le chemin d'une particule garde le quadrant de chaque génération sur 2 bits
+#define GENERATIONS_MAX					8
+// les nœuds des lignées sont compactés quand leur nombre a doublé depuis le
+// dernier compactage, et pas avant d'en compter ce nombre
+#define COMPACTAGE_MIN					1024
 
+typedef struct Base BASE;
 typedef struct Particule PARTICULE;
-struct Particule
+typedef struct Chunk CHUNK;
+typedef struct Classe CLASSE;
+typedef struct Voisinage VOISINAGE;
+typedef struct Sauvegarde SAUVEGARDE;
+
+// particule lue dans le fichier, racine d'une lignée dont les descendants ne
+// gardent que leur chemin depuis elle. Seules les bases dont la lignée compte
+// encore une particule de la liste figurent dans les chunks.
+struct Base
 {
 	C2D position;
-	double energie;
-	PARTICULE * next;
+	REEL energie;
+	int racine;			// numéro de la particule elle-même, -1 si la lignée est éteinte
+	int nb_vivantes;	// particules de la liste dans la lignée
+	int place;
+	CHUNK *chunk;		// chunk contenant la base, à la case place
+};
+
+// nœud d'une lignée en 12 octets, numéroté dans l'ordre de création qui est aussi
+// celui des indices. Sa position, son rayon et son énergie sont déduits de sa base
+// en rejouant les décompositions de son chemin avec les mêmes opérations que
+// decomposer_part(), donc exactement. Une particule décomposée ou éliminée quitte
+// la liste mais reste un nœud jusqu'au prochain compactage.
+struct Particule
+{
+	int base;
+	int enfants;				// numéro du premier des NB_ENFANTS enfants, ou -1
+	unsigned short chemin;		// quadrant de la génération g aux bits 2g et 2g+1
+	unsigned char generation;
+	bool vivante;
+};
+
+// carré (cx, cy) du monde contenant au moins une particule; les chunks sont 
+// rangés dans une table de hachage et libérés dès qu'ils sont vides, la mémoire
+// est ainsi proportionnelle au nombre de particules et non à la taille du monde.
+// Seules les bases des lignées y figurent: R_PARTICULE_FACTOR <= sqrt(2)-1
+// garde les enfants dans le cercle de leur parent, une lignée reste donc dans le
+// cercle de sa base.
+struct Chunk
+{
+	int cx;
+	int cy;
+	int nb;
+	int capacite;
+	int *elements;
+	CHUNK *suivant;
+};
+
+// voisines candidates d'une particule i pour le test de collision
+struct Voisinage
+{
+	int i;
+	int nb;
+	int capacite;
+	int *indices;
+	REEL *x;
+	REEL *y;
+	REEL *r;
+};
+
+// classe de rayon: une décomposition multiplie le rayon par R_PARTICULE_FACTOR,
+// les particules d'une même génération issues de rayons égaux ont donc exactement
+// le même rayon et les classes restent peu nombreuses. Elles sont rangées par
+// rayon décroissant, et leurs membres par numéro donc par indice croissant; une
+// particule qui quitte la liste ne sort du tableau qu'une fois arrivée à sa fin,
+// ou au compactage.
+struct Classe
+{
+	double rayon;
+	int nb_vivantes;
+	int nb;
+	int capacite;
+	int *membres;
+};
+
+// tableaux d'un instantané transmis aux fils qui formatent les lignes du fichier
+struct Sauvegarde
+{
+	const C2D *cercles;
+	const double *energies;
 };
 
 static COULEUR couleur_particule = {0.5, 0.5, 0.5};
-static PARTICULE *tet = NULL; // tête de liste
 static int nb = 0;
 static int nb_precedent=0;
 
+static BASE *bases = NULL;
+static int nb_bases = 0;
+static int capacite_bases = 0;
+
+static PARTICULE *particules = NULL;
+static int nb_noeuds = 0;
+static int capacite_noeuds = 0;
+static int noeuds_gardes = 0;	// nombre de nœuds après le dernier compactage
+// arbre de Fenwick des particules de la liste par numéro, de 1 à nb_noeuds:
+// l'indice d'un numéro et le numéro d'un indice s'obtiennent en O(log n), une
+// élimination ne renumérote rien
+static int *comptes = NULL;
+
+static CHUNK **table = NULL;
+static int capacite_table = 0;
+static int nb_chunks = 0;
+
+static CLASSE *classes = NULL;
+static int nb_classes = 0;
+static int capacite_classes = 0;
+
+static VOISINAGE voisinage = {0, 0, 0, NULL, NULL, NULL, NULL};
+
 /**
  * \brief	NOUVEAU! ajouter une particule PENDANT LA SIMULATION, en fin de liste
  *          le nombre total de particule est incrémenté d'une unité.
@@ -40,44 +158,90 @@ static int nb_precedent=0;
  * 
  * \param pos		C2D avec La position et le rayon de la particule.
  * \param energie	L'énergie de la particule.
+ * \param parent	Le numéro de la particule décomposée.
+ * \param quadrant	Le quadrant de la particule dans son parent, de 0 à 3.
  */
-static void particule_ajouter(C2D pos, double energie);
+static void particule_ajouter(C2D pos, double energie, int parent, int quadrant);
+
+static int particule_creer(int base, int parent, int quadrant);
+static void particule_programmer(int numero, double rayon);
+static int particule_comparer_numeros(const void *a, const void *b);
+static void particule_enfant(C2D parent, int quadrant, C2D *p_enfant);
+static void particule_deduire(int numero, C2D *p_cercle, REEL *p_energie);
+static int particule_indice(int numero);
+static int particule_numero(int indice);
+static void comptes_ajouter(int numero, int delta);
+static void comptes_construire(void);
+static void particule_compacter(void);
+static int chunk_coord(double x);
+static CHUNK** chunk_case(int cx, int cy);
+static void chunk_agrandir_table(void);
+static void chunk_inserer(int base);
+static void chunk_retirer(int base);
+static void chunk_tout_liberer(void);
+static int classe_chercher(double rayon);
+static void classe_inserer(int numero, double rayon);
+static void classe_retirer(int numero, double rayon);
+static void classe_tout_liberer(void);
+static void particule_ajouter_voisine(int indice, C2D cercle, void *donnees);
+static void voisinage_liberer(void);
+static void famille_decompter(int numero);
+static bool famille_vivante(int numero);
+static void famille_garder(int numero, int *nouveaux);
+static bool famille_dans_zone(C2D cercle, S2D coin_min, S2D coin_max);
+static void famille_parcourir(int numero, C2D cercle, S2D coin_min, S2D coin_max,
+							  void (*traiter)(int indice, C2D cercle, void *donnees),
+							  void *donnees);
+static void particule_dessiner_zone(int indice, C2D cercle, void *donnees);
+static int particule_formater_ligne(char *texte, int i, const void *donnees);
 
 
 // initialisation seulement avec lecture fichier et nettoyage liste
 void particule_set_nombre(int nb_part)
 {
 	assert(nb_part >=0);
-	PARTICULE *courant=tet;
 
-	// destruction de toute la liste si nb_part est nul
+	// destruction de toute la liste si nb_part est nul, avec les nœuds des
+	// lignées, qui n'y figurent pas
 	if(nb_part == 0)
 	{
-		while(courant)
-		{
-			tet = courant->next;
-			free(courant);
-			courant = tet;
-		}
-		tet = NULL;
+		free(particules);
+		free(comptes);
+		free(bases);
+		particules = NULL;
+		comptes = NULL;
+		bases = NULL;
+		nb_noeuds = 0;
+		capacite_noeuds = 0;
+		nb_bases = 0;
+		capacite_bases = 0;
+		chunk_tout_liberer();
+		classe_tout_liberer();
+		voisinage_liberer();
+		echeancier_vider();
 	}
 	else
 	{
-		// allocation d'une liste de nb_part éléments non-initialisés sauf next
-		PARTICULE *new;
+		// allocation de nb_part bases non-initialisées, chacune racine de sa lignée
 		int i;
 		
-		for(i=0 ; i< nb_part ; i++)
+		if(nb_bases + nb_part > capacite_bases)
 		{
-			if(!(new = malloc(sizeof(PARTICULE))))
+			capacite_bases = nb_bases + nb_part;
+			if(!(bases = realloc(bases, capacite_bases*sizeof(BASE))))
 				exit(EXIT_FAILURE);
-
-			new->next = tet;
-			tet = new;
+		}
+		for(i=0 ; i< nb_part ; i++)
+		{
+			bases[nb_bases].nb_vivantes = 0;
+			bases[nb_bases].chunk = NULL;
+			bases[nb_bases].racine = particule_creer(nb_bases, -1, 0);
+			nb_bases++;
 		}
 	}
 	nb = nb_part;
 	nb_precedent=nb;
+	noeuds_gardes = nb_noeuds;
 }
 
 // initialisation de l'élément indice dans phase de lecture
@@ -85,31 +249,33 @@ void particule_set_particule(int indice, C2D pos, double energie)
 {
 	assert(0<indice && indice <= nb);
 	
-	PARTICULE *new= tet;
-	int i;
-		
-	for(i=1 ; i< indice ; i++) 
-		new = new-> next;
-				
-	new->position = pos;
-	new->energie  = energie;	
+	int numero = particule_numero(indice);
+	int base = particules[numero].base;
+	
+	assert(particules[numero].generation == 0);
+	if(bases[base].chunk)
+	{
+		chunk_retirer(base);
+		classe_retirer(numero, bases[base].position.rayon);
+	}
+	else
+		particule_programmer(numero, pos.rayon);
+	bases[base].position = pos;
+	bases[base].energie  = energie;
+	chunk_inserer(base);
+	classe_inserer(numero, bases[base].position.rayon);
 }
 
-void particule_ecrire_fichier(FILE *fichier)
+void particule_ecrire_fichier(FILE *fichier, int nb_particules, const C2D *cercles,
+							  const double *energies)
 {	
-	fprintf(fichier, "\n%d\n", nb);
-	if(nb)
+	SAUVEGARDE sauvegarde = {cercles, energies};
+
+	fprintf(fichier, "\n%d\n", nb_particules);
+	if(nb_particules)
 	{
-		PARTICULE *courant = tet;
-	
-		while(courant)
-		{
-			C2D pos = courant->position;
-			fprintf(fichier, "\t%g %g %g %g\n", courant->energie,
-												pos.rayon,
-												pos.centre.x,
-												pos.centre.y);
-		}
+		ecriture_lignes(fichier, nb_particules, 4*ECRITURE_REEL_MAX + 2,
+						particule_formater_ligne, &sauvegarde);
 		fprintf(fichier, "FIN_LISTE\n");
 	}
 }
@@ -121,97 +287,209 @@ int particule_nb_particules(void)
 
 C2D particule_position(int i)
 {
-	PARTICULE *courant = tet;
-	C2D init={{0.,0.},0.};
-	int k=1;
+	C2D init={{0.,0.},0.}, cercle;
+	REEL energie;
 	
-	while(courant)
-	{
-		if(k == i)
-			return courant->position;
-		else
-		{
-			courant = courant->next;
-			k++;
-		}
-	}
-	return init;
+	if(i < 1 || i > nb)
+		return init;
+	particule_deduire(particule_numero(i), &cercle, &energie);
+	return cercle;
 }
 
 double particule_energie(int i)
 {
 	assert(0<i && i <=nb);
 
-	PARTICULE *courant = tet;
-	int k=1;
+	C2D cercle;
+	REEL energie;
 	
-	while(courant)
+	particule_deduire(particule_numero(i), &cercle, &energie);
+	return energie;
+}
+
+// même ordre de sommation que particule_energie() sur les indices croissants
+double particule_energie_totale(void)
+{
+	double somme = 0.;
+	C2D cercle;
+	REEL energie;
+	int numero;
+	
+	for(numero = 0; numero < nb_noeuds; numero++)
 	{
-		if(k == i)
-			return courant->energie;
-		else
-		{
-			courant = courant->next;
-			k++;
-		}
+		if(!particules[numero].vivante)
+			continue;
+		particule_deduire(numero, &cercle, &energie);
+		somme += energie;
 	}
-	return 0.;
+	return somme;
 }
 
+// seuls les chunks et les lignées touchant la partie visible sont parcourus
 void particule_dessiner(void)
 {
-	PARTICULE *courant = tet;
+	S2D coin_min, coin_max;
 	
-	while(courant)
-	{
-		util_dessiner_cercle(courant->position, couleur_particule, true,
+	util_vue(&coin_min, &coin_max);
+	particule_parcourir_zone(coin_min, coin_max, particule_dessiner_zone, NULL);
+}
+
+void particule_dessiner_cercle(C2D cercle)
+{
+	if(util_visible(cercle))
+		util_dessiner_cercle(cercle, couleur_particule, true,
 							 EPAISSEUR_TRAIT_PARTICULE);
-		courant = courant->next;
+}
+
+void particule_exporter(C2D *cercles, double *energies)
+{
+	REEL energie;
+	int numero, i = 0;
+	
+	for(numero = 0; numero < nb_noeuds; numero++)
+	{
+		if(!particules[numero].vivante)
+			continue;
+		particule_deduire(numero, &cercles[i], &energie);
+		if(energies)
+			energies[i] = energie;
+		i++;
 	}
 }
 
-bool particule_collision(int i)
+// les classes sont parcourues par rayon décroissant et chacune à partir de la fin,
+// à rayon égal le plus grand indice vient donc en premier
+int particule_plus_grosses(int k, int *indices)
 {
-	int j=1;
-	PARTICULE *courant = tet, *part_i=NULL;;
-	double dist = 0.;
+	int c, j, n = 0;
+	CLASSE *classe;
 	
-	while(courant)
+	for(c = 0; c < nb_classes && n < k; c++)
 	{
-		if(j == i)
+		classe = &classes[c];
+		for(j = classe->nb-1; j >= 0 && n < k; j--)
 		{
-			part_i = courant;
-			break;
+			if(particules[classe->membres[j]].vivante)
+				indices[n++] = particule_indice(classe->membres[j]);
 		}
-		else
+	}
+	return n;
+}
+
+// parcourt les chunks pouvant contenir une particule qui touche la zone; si la
+// zone couvre plus de cases qu'il n'existe de chunks, la table est parcourue
+void particule_parcourir_zone(S2D coin_min, S2D coin_max,
+							  void (*traiter)(int indice, C2D cercle, void *donnees),
+							  void *donnees)
+{
+	int i, k, cx, cy;
+	int cx_min = chunk_coord(coin_min.x - R_PARTICULE_MAX);
+	int cx_max = chunk_coord(coin_max.x + R_PARTICULE_MAX);
+	int cy_min = chunk_coord(coin_min.y - R_PARTICULE_MAX);
+	int cy_max = chunk_coord(coin_max.y + R_PARTICULE_MAX);
+	CHUNK *chunk;
+	BASE *base;
+	
+	if(!nb_chunks)
+		return;
+	if((double)(cx_max-cx_min+1)*(cy_max-cy_min+1) > nb_chunks)
+	{
+		for(i = 0; i < capacite_table; i++)
 		{
-			courant = courant->next;
-			j++;
+			for(chunk = table[i]; chunk; chunk = chunk->suivant)
+			{
+				if(chunk->cx < cx_min || chunk->cx > cx_max ||
+				   chunk->cy < cy_min || chunk->cy > cy_max)
+					continue;
+				for(k = 0; k < chunk->nb; k++)
+				{
+					base = &bases[chunk->elements[k]];
+					famille_parcourir(base->racine, base->position, coin_min,
+									  coin_max, traiter, donnees);
+				}
+			}
 		}
+		return;
 	}
-
-	if(part_i)
+	for(cx = cx_min; cx <= cx_max; cx++)
 	{
-		j=1;
-		courant= tet;
-
-		while(courant && courant != part_i)
+		for(cy = cy_min; cy <= cy_max; cy++)
 		{
-			if(util_collision_cercle(part_i->position, courant->position, &dist))
+			if(!(chunk = *chunk_case(cx, cy)))
+				continue;
+			for(k = 0; k < chunk->nb; k++)
 			{
-				error_collision(PARTICULE_PARTICULE, i,j);
-				return true;
+				base = &bases[chunk->elements[k]];
+				famille_parcourir(base->racine, base->position, coin_min, coin_max,
+								  traiter, donnees);
 			}
-			courant = courant->next;
-			j++;		
+		}
+	}
+}
+// voisines d'indice inférieur à la particule testée, rangées en tableaux séparés
+// pour être testées par lots avec util_collision_lot
+static void particule_ajouter_voisine(int indice, C2D cercle, void *donnees)
+{
+	VOISINAGE *v = donnees;
+	
+	if(indice >= v->i)
+		return;
+	if(v->nb == v->capacite)
+	{
+		v->capacite = v->capacite ? 2*v->capacite : CAPACITE_VOISINES_MIN;
+		if(!(v->indices = realloc(v->indices, v->capacite*sizeof(int))) ||
+		   !(v->x = realloc(v->x, v->capacite*sizeof(REEL))) ||
+		   !(v->y = realloc(v->y, v->capacite*sizeof(REEL))) ||
+		   !(v->r = realloc(v->r, v->capacite*sizeof(REEL))))
+			exit(EXIT_FAILURE);
+	}
+	v->indices[v->nb] = indice;
+	v->x[v->nb] = cercle.centre.x;
+	v->y[v->nb] = cercle.centre.y;
+	v->r[v->nb] = cercle.rayon;
+	v->nb++;
+}
+
+
+// la collision signalée est celle de plus petit indice
+bool particule_collision(int i)
+{
+	C2D cercle;
+	REEL energie;
+	S2D coin_min, coin_max;
+	int j, k, collision = 0;
+
+	if(0 < i && i <= nb)
+	{
+		particule_deduire(particule_numero(i), &cercle, &energie);
+		voisinage.i = i;
+		voisinage.nb = 0;
+		coin_min.x = cercle.centre.x - cercle.rayon;
+		coin_min.y = cercle.centre.y - cercle.rayon;
+		coin_max.x = cercle.centre.x + cercle.rayon;
+		coin_max.y = cercle.centre.y + cercle.rayon;
+		particule_parcourir_zone(coin_min, coin_max, particule_ajouter_voisine,
+								 &voisinage);
+		for(j = 0; j < voisinage.nb &&
+				   (k = util_collision_lot(cercle, &voisinage.x[j],
+											 &voisinage.y[j], &voisinage.r[j],
+											 voisinage.nb - j)) >= 0; j += k+1)
+		{
+			if(!collision || voisinage.indices[j+k] < collision)
+				collision = voisinage.indices[j+k];
+		}
+		if(collision)
+		{
+			error_collision(PARTICULE_PARTICULE, i, collision);
+			return true;
 		}
 	}
 	return false;
 }
 
-bool particule_is_valid(C2D pos, double energie)
+bool particule_is_valid(C2D pos, double energie, double dmax)
 {
-	return !util_point_dehors(pos.centre, DMAX) &&
+	return !util_point_dehors(pos.centre, dmax) &&
 		   pos.rayon <= R_PARTICULE_MAX			&&
 		   pos.rayon >= R_PARTICULE_MIN 		&&
 		   energie   <= E_PARTICULE_MAX			&&
@@ -221,124 +499,77 @@ bool particule_is_valid(C2D pos, double energie)
 //
 // fonction interne au module à utiliser dans future fonction particule_decomposition()
 //
-static void particule_ajouter(C2D pos, double energie)
+static void particule_ajouter(C2D pos, double energie, int parent, int quadrant)
 {
-	PARTICULE *new, *courant;
-	
-	if(!(new = malloc(sizeof(PARTICULE))))
-		exit(EXIT_FAILURE);
-		
-	new->position = pos;
-	new->energie  = energie;
-	new->next     = NULL;
-	
-	if(!tet) tet = new;
-	else
-	{
-		courant = tet;
-		while(courant->next)
-			courant = courant->next;
-			
-		courant->next = new;
-	}
+	int numero = particule_creer(particules[parent].base, parent, quadrant);
 	
+	classe_inserer(numero, pos.rayon);
+	particule_programmer(numero, pos.rayon);
+	trajectoire_naissance(pos, energie);
 	nb++;
 }
 
-bool condition_decomposition(void)
-{
-    double p = rand()%RAND_MAX;
-    p/=RAND_MAX;
-    if (p <= DECOMPOSITION_RATE)
-        return true;
-    else
-        return false;
-}
-
-PARTICULE* chercher_particule(int i)
-{
-    PARTICULE *courant = tet;
-    int k=1;
-    
-    while(courant)
-    {
-        if(k == i)
-            return courant;
-        else
-        {
-            courant = courant->next;
-            k++;
-        }
-    }
-    return NULL;
-}
-
 void eliminer_particule(int id)
 {
-    if(id>1)
-    {
-        PARTICULE * precedent = chercher_particule(id-1);
-        PARTICULE * courant = precedent->next;
-        if (courant==NULL)
-            return;
-        if (courant!=tet)
-        {
-            precedent->next = courant->next;
-            free(courant);
-            nb--;
-        }
-    }
-    else
-    {
-        PARTICULE * part = chercher_particule(id);
-        if (part==NULL)
-            return;
-        tet= part->next;
-        free(part);
-        nb--;
-    }
+    int numero;
+    C2D cercle;
+    REEL energie;
+    
+    if (id<1 || id>nb)
+        return;
+    numero = particule_numero(id);
+    particule_deduire(numero, &cercle, &energie);
+    particules[numero].vivante = false;
+    comptes_ajouter(numero, -1);
+    classe_retirer(numero, cercle.rayon);
+    famille_decompter(numero);
+    nb--;
+    trajectoire_deces(id);
 }
 
 void decomposer_part(int id)
 {
-    PARTICULE* part = chercher_particule(id);
-    if (part==NULL || part->position.rayon*R_PARTICULE_FACTOR < R_PARTICULE_MIN)
-        return;
-    C2D pos;
+    int numero, quadrant;
+    C2D parent, pos;
+    REEL energie_parent;
     double energie;
-    pos.rayon=part->position.rayon*R_PARTICULE_FACTOR;
-    energie = part->energie*E_PARTICULE_FACTOR;
-    
-    pos.centre.x=part->position.centre.x+pos.rayon;
-    pos.centre.y=part->position.centre.y+pos.rayon;
-    particule_ajouter(pos, energie);
     
-    pos.centre.x=part->position.centre.x-pos.rayon;
-    pos.centre.y=part->position.centre.y+pos.rayon;
-    particule_ajouter(pos, energie);
-    
-    pos.centre.x=part->position.centre.x-pos.rayon;
-    pos.centre.y=part->position.centre.y-pos.rayon;
-    particule_ajouter(pos, energie);
+    if (id<1 || id>nb)
+        return;
+    numero = particule_numero(id);
+    particule_deduire(numero, &parent, &energie_parent);
+    if (parent.rayon*R_PARTICULE_FACTOR < R_PARTICULE_MIN)
+        return;
+    energie = energie_parent*E_PARTICULE_FACTOR;
     
-    pos.centre.x=part->position.centre.x+pos.rayon;
-    pos.centre.y=part->position.centre.y-pos.rayon;
-    particule_ajouter(pos, energie);
+    // les quatre enfants occupent des numéros consécutifs
+    particules[numero].enfants = nb_noeuds;
+    for (quadrant=0; quadrant<NB_ENFANTS; quadrant++)
+    {
+        particule_enfant(parent, quadrant, &pos);
+        particule_ajouter(pos, energie, numero, quadrant);
+    }
     
+    // la particule quitte la liste et devient le nœud parent de ses enfants
     eliminer_particule(id);
 }
 
+// seules les particules arrivées à échéance sont parcourues, par indice
+// croissant comme dans la liste; leurs enfants sont programmés à leur naissance
 void decomposition(void)
 {
-    int i=0, j=1;
-    int nb_particules=nb;
-    for (i=0; i<nb_particules; i++)
+    int *dus, nb_dus, k;
+    
+    nb_dus = echeancier_avancer(&dus);
+    if (nb_dus > 1)
+        qsort(dus, nb_dus, sizeof(int), particule_comparer_numeros);
+    for (k=0; k<nb_dus; k++)
     {
-        if (condition_decomposition())
-            decomposer_part(j);
-        else
-            j++;
+        if (particules[dus[k]].vivante)
+            decomposer_part(particule_indice(dus[k]));
     }
+    if (nb_noeuds > COMPACTAGE_MIN && nb_noeuds > 2*noeuds_gardes)
+        particule_compacter();
 }
 
 bool update_nb_part(void)
@@ -351,21 +582,318 @@ bool update_nb_part(void)
 
 void supprimer_tout_part(void)
 {
-	PARTICULE* e1;
 	printf("BEGIN\n");
-	while (nb > 0)
+	particule_set_nombre(0);
+	printf("end\n");
+}
+
+// nouveau nœud vivant en fin de tableau; parent vaut -1 pour une base
+static int particule_creer(int base, int parent, int quadrant)
+{
+	int numero = nb_noeuds, k = nb_noeuds+1, fils;
+	PARTICULE *part;
+	
+	if(nb_noeuds == capacite_noeuds)
+	{
+		capacite_noeuds = capacite_noeuds ? 2*capacite_noeuds
+										  : CAPACITE_PARTICULES_MIN;
+		if(!(particules = realloc(particules, capacite_noeuds*sizeof(PARTICULE))) ||
+		   !(comptes = realloc(comptes, (capacite_noeuds+1)*sizeof(int))))
+			exit(EXIT_FAILURE);
+	}
+	part = &particules[numero];
+	part->base = base;
+	part->enfants = -1;
+	part->vivante = true;
+	if(parent < 0)
 	{
-		e1=tet;
-		while (e1->next != NULL)
+		part->chemin = 0;
+		part->generation = 0;
+	}
+	else
+	{
+		assert(particules[parent].generation < GENERATIONS_MAX);
+		part->chemin = particules[parent].chemin |
+					   quadrant << 2*particules[parent].generation;
+		part->generation = particules[parent].generation+1;
+	}
+	// le nœud k de l'arbre de Fenwick couvre les numéros ]k - (k & -k), k]
+	comptes[k] = 1;
+	for(fils = k-1; fils > k - (k & -k); fils -= fils & -fils)
+		comptes[k] += comptes[fils];
+	nb_noeuds++;
+	bases[base].nb_vivantes++;
+	return numero;
+}
+
+// une particule décomposable a une chance DECOMPOSITION_RATE de se décomposer à
+// chaque tour qui suit sa naissance: le tour où elle se décompose suit une loi
+// géométrique, tirée une fois pour toutes par inversion. Un pas DELTA_T
+// regroupe DELTA_T/DELTA_T_REFERENCE tours de référence, la chance par tour est
+// donc 1-(1-DECOMPOSITION_RATE)^(DELTA_T/DELTA_T_REFERENCE). Une particule trop
+// petite pour se décomposer n'est pas programmée.
+static void particule_programmer(int numero, double rayon)
+{
+	double u;
+	
+	if(rayon*R_PARTICULE_FACTOR < R_PARTICULE_MIN)
+		return;
+	u = (rand() + 1.)/(RAND_MAX + 1.);
+	echeancier_programmer(numero, echeancier_tour() + 1 +
+					   (unsigned int)floor(log(u)/(DELTA_T/DELTA_T_REFERENCE*
+												 log1p(-DECOMPOSITION_RATE))));
+}
+
+static int particule_comparer_numeros(const void *a, const void *b)
+{
+	return *(const int *)a - *(const int *)b;
+}
+
+// mêmes opérations et même précision que la décomposition d'origine
+static void particule_enfant(C2D parent, int quadrant, C2D *p_enfant)
+{
+	C2D pos;
+	
+	pos.rayon = parent.rayon*R_PARTICULE_FACTOR;
+	if(quadrant == 0 || quadrant == 3)
+		pos.centre.x = parent.centre.x+pos.rayon;
+	else
+		pos.centre.x = parent.centre.x-pos.rayon;
+	if(quadrant < 2)
+		pos.centre.y = parent.centre.y+pos.rayon;
+	else
+		pos.centre.y = parent.centre.y-pos.rayon;
+	*p_enfant = pos;
+}
+
+static void particule_deduire(int numero, C2D *p_cercle, REEL *p_energie)
+{
+	PARTICULE *part = &particules[numero];
+	C2D cercle = bases[part->base].position;
+	REEL energie = bases[part->base].energie;
+	int g;
+	
+	for(g = 0; g < part->generation; g++)
+	{
+		particule_enfant(cercle, (part->chemin >> 2*g) & 3, &cercle);
+		energie = energie*E_PARTICULE_FACTOR;
+	}
+	*p_cercle = cercle;
+	*p_energie = energie;
+}
+
+// nombre de particules de la liste de numéro inférieur ou égal
+static int particule_indice(int numero)
+{
+	int k, indice = 0;
+	
+	for(k = numero+1; k > 0; k -= k & -k)
+		indice += comptes[k];
+	return indice;
+}
+
+// descente dans l'arbre de Fenwick, par puissances de deux décroissantes
+static int particule_numero(int indice)
+{
+	int pas, k = 0;
+	
+	for(pas = 1; 2*pas <= nb_noeuds; pas *= 2);
+	for(; pas; pas /= 2)
+	{
+		if(k+pas <= nb_noeuds && comptes[k+pas] < indice)
 		{
-			e1=e1->next;	
+			k += pas;
+			indice -= comptes[k];
 		}
-		nb--;
-		free(e1->next);
 	}
-	free(tet);
-	tet=NULL;
-	printf("end\n");
+	return k;
+}
+
+static void comptes_ajouter(int numero, int delta)
+{
+	int k;
+	
+	for(k = numero+1; k <= nb_noeuds; k += k & -k)
+		comptes[k] += delta;
+}
+
+static void comptes_construire(void)
+{
+	int k;
+	
+	for(k = 1; k <= nb_noeuds; k++)
+		comptes[k] = particules[k-1].vivante;
+	for(k = 1; k <= nb_noeuds; k++)
+	{
+		if(k + (k & -k) <= nb_noeuds)
+			comptes[k + (k & -k)] += comptes[k];
+	}
+}
+
+// les lignées éteintes et les sous-arbres sans particule de la liste sont
+// retirés; les nœuds restants gardent leur ordre, les indices ne changent donc
+// pas. Les enfants d'un nœud gardé le sont tous et restent consécutifs.
+static void particule_compacter(void)
+{
+	int *nouveaux, numero, b, c, n = 0;
+	PARTICULE part;
+	C2D cercle;
+	REEL energie;
+	CLASSE *classe;
+	
+	if(!(nouveaux = malloc(nb_noeuds*sizeof(int))))
+		exit(EXIT_FAILURE);
+	for(numero = 0; numero < nb_noeuds; numero++)
+		nouveaux[numero] = -1;
+	for(b = 0; b < nb_bases; b++)
+	{
+		if(bases[b].nb_vivantes)
+			famille_garder(bases[b].racine, nouveaux);
+	}
+	for(numero = 0; numero < nb_noeuds; numero++)
+	{
+		if(nouveaux[numero] >= 0)
+			nouveaux[numero] = n++;
+	}
+	for(numero = 0; numero < nb_noeuds; numero++)
+	{
+		if(nouveaux[numero] < 0)
+			continue;
+		part = particules[numero];
+		if(part.enfants >= 0)
+			part.enfants = nouveaux[part.enfants];
+		particules[nouveaux[numero]] = part;
+	}
+	for(b = 0; b < nb_bases; b++)
+		bases[b].racine = bases[b].nb_vivantes ? nouveaux[bases[b].racine] : -1;
+	echeancier_renumeroter(nouveaux);
+	free(nouveaux);
+	nb_noeuds = n;
+	noeuds_gardes = n;
+	comptes_construire();
+	
+	for(c = 0; c < nb_classes; c++)
+		classes[c].nb = 0;
+	for(numero = 0; numero < nb_noeuds; numero++)
+	{
+		if(!particules[numero].vivante)
+			continue;
+		particule_deduire(numero, &cercle, &energie);
+		classe = &classes[classe_chercher(cercle.rayon)];
+		classe->membres[classe->nb++] = numero;
+	}
+}
+static int chunk_coord(double x)
+{
+	return (int)floor(x/TAILLE_CHUNK);
+}
+
+// case de la table de hachage où est (ou serait) chaîné le chunk (cx, cy)
+static CHUNK** chunk_case(int cx, int cy)
+{
+	unsigned int h = ((unsigned int)cx*73856093u ^ (unsigned int)cy*19349663u) &
+					 (capacite_table-1);
+	CHUNK **p_chunk = &table[h];
+	
+	while(*p_chunk && ((*p_chunk)->cx != cx || (*p_chunk)->cy != cy))
+		p_chunk = &(*p_chunk)->suivant;
+	return p_chunk;
+}
+
+// double la table quand le nombre de chunks dépasse sa capacité
+static void chunk_agrandir_table(void)
+{
+	CHUNK **ancienne = table, *chunk;
+	int i, ancienne_capacite = capacite_table;
+	
+	capacite_table = capacite_table ? 2*capacite_table : CAPACITE_TABLE_MIN;
+	if(!(table = calloc(capacite_table, sizeof(CHUNK*))))
+		exit(EXIT_FAILURE);
+	for(i = 0; i < ancienne_capacite; i++)
+	{
+		while((chunk = ancienne[i]))
+		{
+			ancienne[i] = chunk->suivant;
+			chunk->suivant = NULL;
+			*chunk_case(chunk->cx, chunk->cy) = chunk;
+		}
+	}
+	free(ancienne);
+}
+
+static void chunk_inserer(int base)
+{
+	int cx = chunk_coord(bases[base].position.centre.x);
+	int cy = chunk_coord(bases[base].position.centre.y);
+	CHUNK **p_chunk, *chunk;
+	
+	if(nb_chunks >= capacite_table)
+		chunk_agrandir_table();
+	p_chunk = chunk_case(cx, cy);
+	if(!(chunk = *p_chunk))
+	{
+		if(!(chunk = malloc(sizeof(CHUNK))))
+			exit(EXIT_FAILURE);
+		chunk->cx = cx;
+		chunk->cy = cy;
+		chunk->nb = 0;
+		chunk->capacite = 0;
+		chunk->elements = NULL;
+		chunk->suivant = NULL;
+		*p_chunk = chunk;
+		nb_chunks++;
+	}
+	if(chunk->nb == chunk->capacite)
+	{
+		chunk->capacite = chunk->capacite ? 2*chunk->capacite : CAPACITE_CHUNK_MIN;
+		if(!(chunk->elements = realloc(chunk->elements,
+									   chunk->capacite*sizeof(int))))
+			exit(EXIT_FAILURE);
+	}
+	bases[base].chunk = chunk;
+	bases[base].place = chunk->nb;
+	chunk->elements[chunk->nb++] = base;
+}
+
+// la dernière base du chunk prend la place libérée; un chunk vide est libéré
+static void chunk_retirer(int base)
+{
+	CHUNK *chunk = bases[base].chunk, **p_chunk;
+	int place = bases[base].place;
+	
+	if(!chunk)
+		return;
+	chunk->elements[place] = chunk->elements[--chunk->nb];
+	bases[chunk->elements[place]].place = place;
+	bases[base].chunk = NULL;
+	if(chunk->nb == 0)
+	{
+		p_chunk = chunk_case(chunk->cx, chunk->cy);
+		*p_chunk = chunk->suivant;
+		free(chunk->elements);
+		free(chunk);
+		nb_chunks--;
+	}
+}
+
+static void chunk_tout_liberer(void)
+{
+	CHUNK *chunk;
+	int i;
+	
+	for(i = 0; i < capacite_table; i++)
+	{
+		while((chunk = table[i]))
+		{
+			table[i] = chunk->suivant;
+			free(chunk->elements);
+			free(chunk);
+		}
+	}
+	free(table);
+	table = NULL;
+	capacite_table = 0;
+	nb_chunks = 0;
 }
 
 
@@ -373,3 +901,211 @@ void supprimer_tout_part(void)
 
 
 
+
+// position de la classe du rayon dans le tableau trié par rayon décroissant, ou
+// de la place où l'insérer si elle n'existe pas
+static int classe_chercher(double rayon)
+{
+	int debut = 0, fin = nb_classes, milieu;
+	
+	while(debut < fin)
+	{
+		milieu = (debut+fin)/2;
+		if(classes[milieu].rayon > rayon)
+			debut = milieu+1;
+		else
+			fin = milieu;
+	}
+	return debut;
+}
+
+// les particules lues dans le fichier peuvent arriver dans le désordre, les
+// autres sont ajoutées en fin de liste: la remontée depuis la fin de la classe
+// est alors immédiate
+static void classe_inserer(int numero, double rayon)
+{
+	int c = classe_chercher(rayon), j;
+	CLASSE *classe;
+	
+	if(c == nb_classes || classes[c].rayon != rayon)
+	{
+		if(nb_classes == capacite_classes)
+		{
+			capacite_classes = capacite_classes ? 2*capacite_classes
+												: CAPACITE_CLASSES_MIN;
+			if(!(classes = realloc(classes, capacite_classes*sizeof(CLASSE))))
+				exit(EXIT_FAILURE);
+		}
+		memmove(&classes[c+1], &classes[c], (nb_classes-c)*sizeof(CLASSE));
+		classes[c] = (CLASSE){rayon, 0, 0, 0, NULL};
+		nb_classes++;
+	}
+	classe = &classes[c];
+	if(classe->nb == classe->capacite)
+	{
+		classe->capacite = classe->capacite ? 2*classe->capacite
+											: CAPACITE_MEMBRES_MIN;
+		if(!(classe->membres = realloc(classe->membres,
+									   classe->capacite*sizeof(int))))
+			exit(EXIT_FAILURE);
+	}
+	for(j = classe->nb; j > 0 && classe->membres[j-1] > numero; j--);
+	memmove(&classe->membres[j+1], &classe->membres[j],
+			(classe->nb-j)*sizeof(int));
+	classe->membres[j] = numero;
+	classe->nb++;
+	classe->nb_vivantes++;
+}
+
+// une particule relue est retirée aussitôt; une particule qui quitte la liste
+// reste dans le tableau, dont la fin est débarrassée des particules éliminées
+static void classe_retirer(int numero, double rayon)
+{
+	int c = classe_chercher(rayon), j;
+	CLASSE *classe = &classes[c];
+	
+	if(particules[numero].vivante)
+	{
+		for(j = classe->nb-1; classe->membres[j] != numero; j--);
+		memmove(&classe->membres[j], &classe->membres[j+1],
+				(classe->nb-j-1)*sizeof(int));
+		classe->nb--;
+	}
+	if(!--classe->nb_vivantes)
+	{
+		free(classe->membres);
+		memmove(&classes[c], &classes[c+1], (nb_classes-c-1)*sizeof(CLASSE));
+		nb_classes--;
+		return;
+	}
+	while(!particules[classe->membres[classe->nb-1]].vivante)
+		classe->nb--;
+}
+
+static void classe_tout_liberer(void)
+{
+	int c;
+	
+	for(c = 0; c < nb_classes; c++)
+		free(classes[c].membres);
+	free(classes);
+	classes = NULL;
+	nb_classes = 0;
+	capacite_classes = 0;
+}
+
+static void voisinage_liberer(void)
+{
+	free(voisinage.indices);
+	free(voisinage.x);
+	free(voisinage.y);
+	free(voisinage.r);
+	voisinage = (VOISINAGE){0, 0, 0, NULL, NULL, NULL, NULL};
+}
+
+// la particule vient de quitter la liste: une lignée entièrement décontaminée
+// sort de son chunk avec sa dernière particule, ses nœuds sont récupérés au
+// prochain compactage
+static void famille_decompter(int numero)
+{
+	int base = particules[numero].base;
+	
+	if(!--bases[base].nb_vivantes)
+		chunk_retirer(base);
+}
+
+static bool famille_vivante(int numero)
+{
+	int k;
+	
+	if(particules[numero].vivante)
+		return true;
+	if(particules[numero].enfants < 0)
+		return false;
+	for(k = 0; k < NB_ENFANTS; k++)
+	{
+		if(famille_vivante(particules[numero].enfants + k))
+			return true;
+	}
+	return false;
+}
+
+// le nœud est gardé, ses descendants seulement s'il y reste une particule de la
+// liste
+static void famille_garder(int numero, int *nouveaux)
+{
+	int k;
+	
+	nouveaux[numero] = 0;
+	if(particules[numero].enfants < 0)
+		return;
+	if(!famille_vivante(numero))
+	{
+		particules[numero].enfants = -1;
+		return;
+	}
+	for(k = 0; k < NB_ENFANTS; k++)
+		famille_garder(particules[numero].enfants + k, nouveaux);
+}
+
+// les enfants restent dans le cercle de leur parent, qui englobe donc le
+// sous-arbre
+static bool famille_dans_zone(C2D cercle, S2D coin_min, S2D coin_max)
+{
+	double dx = fmax(0., fmax(coin_min.x - cercle.centre.x,
+							  cercle.centre.x - coin_max.x));
+	double dy = fmax(0., fmax(coin_min.y - cercle.centre.y,
+							  cercle.centre.y - coin_max.y));
+	return dx*dx + dy*dy <= cercle.rayon*cercle.rayon;
+}
+
+// un sous-arbre dont le cercle ne touche pas la zone est ignoré; les cercles des
+// enfants sont déduits en descendant
+static void famille_parcourir(int numero, C2D cercle, S2D coin_min, S2D coin_max,
+							  void (*traiter)(int indice, C2D cercle, void *donnees),
+							  void *donnees)
+{
+	int k, enfants = particules[numero].enfants;
+	C2D enfant;
+	
+	if(particules[numero].vivante)
+	{
+		traiter(particule_indice(numero), cercle, donnees);
+		return;
+	}
+	if(enfants < 0)
+		return;
+	for(k = 0; k < NB_ENFANTS; k++)
+	{
+		particule_enfant(cercle, k, &enfant);
+		if(famille_dans_zone(enfant, coin_min, coin_max))
+			famille_parcourir(enfants + k, enfant, coin_min, coin_max, traiter,
+							  donnees);
+	}
+}
+
+static void particule_dessiner_zone(int indice, C2D cercle, void *donnees)
+{
+	(void)indice;
+	(void)donnees;
+	particule_dessiner_cercle(cercle);
+}
+
+// "\tenergie rayon x y\n"
+static int particule_formater_ligne(char *texte, int i, const void *donnees)
+{
+	const SAUVEGARDE *sauvegarde = donnees;
+	const C2D *cercle = &sauvegarde->cercles[i];
+	int n = 0;
+
+	texte[n++] = '\t';
+	n += ecriture_reel(&texte[n], sauvegarde->energies[i]);
+	texte[n++] = ' ';
+	n += ecriture_reel(&texte[n], cercle->rayon);
+	texte[n++] = ' ';
+	n += ecriture_reel(&texte[n], cercle->centre.x);
+	texte[n++] = ' ';
+	n += ecriture_reel(&texte[n], cercle->centre.y);
+	texte[n++] = '\n';
+	return n;
+}
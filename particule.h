@@ -1,7 +1,7 @@
 /*!
  \file particule.h
  \brief Module gérant le type opaque particule
-         implementation avec une liste
+         implementation avec des tableaux compacts
 \author Simon Gilgien
  \group Sylvain Pellegrini
 		Simon Gilgien
@@ -33,11 +33,16 @@ void particule_set_nombre(int nb_part);
 void particule_set_particule(int indice, C2D pos, double energie);
 
 /**
- * \brief			écriture de l'ensemble des particules dans un fichier.
- * \param fichier	pointeur vers le fichier ouvert en écriture
-
+ * \brief			écriture d'un ensemble de particules dans un fichier, par
+ *					exemple celles d'une image de la simulation (voir
+ *					particule_exporter).
+ * \param fichier		pointeur vers le fichier ouvert en écriture
+ * \param nb_particules	le nombre de particules
+ * \param cercles		les positions des particules
+ * \param energies		les énergies des particules
  */
-void particule_ecrire_fichier(FILE *fichier);
+void particule_ecrire_fichier(FILE *fichier, int nb_particules, const C2D *cercles,
+							  const double *energies);
 
 /**
  * \brief	Retourne le nombre de particules existantes, c'est-à-dire le plus grand
@@ -60,6 +65,12 @@ C2D particule_position(int i);
  */
 double particule_energie(int i);
 
+/**
+ * \brief	Retourne la somme des énergies des particules, dans l'ordre des
+ *			indices, en un seul parcours.
+ */
+double particule_energie_totale(void);
+
 /**
  * \brief	Contrôle si la particule d'indice i est en collision avec l'une des  
  *          particules d'indice inférieur à i.
@@ -68,18 +79,56 @@ double particule_energie(int i);
 bool particule_collision(int i);
 
 /**
- * \brief	Dessine l'état actuel des particules
+ * \brief	Dessine l'état actuel des particules qui touchent la partie visible
+ *			du dessin en cours.
  */
 void particule_dessiner(void);
 
+/**
+ * \brief	Dessine une particule donnée par sa position, indépendamment de la
+ *			liste (relecture d'une trajectoire), si elle touche la partie visible.
+ */
+void particule_dessiner_cercle(C2D cercle);
+
+/**
+ * \brief	Copie les positions et énergies de toutes les particules, dans l'ordre
+ *			des indices.
+ * \param cercles	Tableau d'au moins particule_nb_particules() éléments.
+ * \param energies	Tableau d'au moins particule_nb_particules() éléments, ou
+ *					NULL si les énergies ne sont pas utiles.
+ */
+void particule_exporter(C2D *cercles, double *energies);
+
+/**
+ * \brief	Donne les indices des k plus grosses particules par rayon décroissant,
+ *			à rayon égal par indice décroissant, en O(k log n) et sans tri: les
+ *			particules sont tenues à jour dans des classes de rayon.
+ * \param k			Le nombre de particules voulues.
+ * \param indices	Tableau d'au moins k éléments.
+ * \return	Le nombre d'indices écrits, min(k, particule_nb_particules()).
+ */
+int particule_plus_grosses(int k, int *indices);
+
+/**
+ * \brief	Appelle traiter pour chaque particule pouvant toucher la zone
+ *			rectangulaire donnée, en ne visitant que les chunks voisins de la 
+ *			zone. L'ordre de parcours ne suit pas les indices.
+ * \param coin_min	Le coin inférieur gauche de la zone.
+ * \param coin_max	Le coin supérieur droit de la zone.
+ * \param traiter	Fonction recevant l'indice et la position de la particule.
+ * \param donnees	Pointeur transmis tel quel à traiter.
+ */
+void particule_parcourir_zone(S2D coin_min, S2D coin_max,
+							  void (*traiter)(int indice, C2D cercle, void *donnees),
+							  void *donnees);
+
 /**
  * \brief	Contrôle que les données fournies forment une particule valide.
  * \param pos		La position à tester.
  * \param energie	L'énergie à tester.
+ * \param dmax		La demi-largeur du monde.
  */
-bool particule_is_valid(C2D pos, double energie);
-
-bool condition_decomposition(void);
+bool particule_is_valid(C2D pos, double energie, double dmax);
 
 void eliminer_particule(int id);
 
@@ -0,0 +1,353 @@
+/*!
+ \file rendu.c
+ \brief Module de rendu logiciel: les cercles et segments du dessin sont
+        rastérisés dans une image en mémoire par plusieurs fils, sans OpenGL,
+        puis écrits en PPM ou envoyés bruts à un encodeur
+ \author agent
+ \group Sylvain Pellegrini
+		Simon Gilgien
+ \version 1.0
+ \date 19 octobre 2026
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include "rendu.h"
+
+#define HAUTEUR_BANDE	16
+#define RAYON_POINT		0.5
+#define LARGEUR_MIN		1.
+#define LONGUEUR_NOM	1024
+#define SORTIE_STANDARD	"-"
+#define NB_FILS_MAX		64
+
+enum Primitives
+{
+	PRIMITIVE_CERCLE, PRIMITIVE_SEGMENT
+};
+
+// un cercle est centré en a; le rayon d'un segment est sa demi-largeur
+typedef struct Primitive PRIMITIVE;
+struct Primitive
+{
+	unsigned char type;
+	bool plein;
+	unsigned char couleur[3];
+	double x_a, y_a;
+	double x_b, y_b;
+	double rayon;
+	double epaisseur;
+};
+
+// copies des primitives touchant une bande de HAUTEUR_BANDE lignes, dans
+// l'ordre du dessin: chaque fil lit sa bande d'un seul tenant, sans sauter d'une
+// primitive à l'autre dans une liste commune trop grande pour le cache
+typedef struct Bande BANDE;
+struct Bande
+{
+	PRIMITIVE *primitives;
+	int nb;
+	int capacite;
+};
+
+static bool actif = false;
+static int largeur = 0, hauteur = 0;
+static int nb_fils = 1;
+static char prefixe[LONGUEUR_NOM];
+static unsigned char *image = NULL;
+static unsigned char fond[3];
+static BANDE *bandes = NULL;
+static int nb_bandes = 0;
+static atomic_int bande_suivante;
+
+static void rendu_ajouter(const PRIMITIVE *primitive, double y_min, double y_max);
+static void rendu_couleur(const float *couleur, unsigned char *octets);
+static void* rendu_travailler(void *inutile);
+static void rendu_bande(int b);
+static void rendu_cercle_bande(const PRIMITIVE *cercle, int y_debut, int y_fin);
+static void rendu_segment_bande(const PRIMITIVE *segment, int y_debut, int y_fin);
+static void rendu_ligne(int y, double x_debut, double x_fin,
+						const unsigned char *couleur);
+static void rendu_pixel(int x, int y, const unsigned char *couleur);
+static int rendu_premier(double v, int min);
+static int rendu_dernier(double v, int max);
+
+bool rendu_ouvrir(int largeur_image, int hauteur_image, int fils,
+				  const char *nom)
+{
+	rendu_fermer();
+	if (!(image = malloc((size_t)largeur_image*hauteur_image*3)))
+		return false;
+	nb_bandes = (hauteur_image + HAUTEUR_BANDE - 1)/HAUTEUR_BANDE;
+	if (!(bandes = calloc(nb_bandes, sizeof(BANDE))))
+	{
+		free(image);
+		image = NULL;
+		return false;
+	}
+	largeur = largeur_image;
+	hauteur = hauteur_image;
+	nb_fils = fils < 1 ? 1 : fils > NB_FILS_MAX ? NB_FILS_MAX : fils;
+	snprintf(prefixe, LONGUEUR_NOM, "%s", nom);
+	actif = true;
+	return true;
+}
+
+void rendu_fermer(void)
+{
+	int b;
+	for (b = 0; b < nb_bandes; b++)
+		free(bandes[b].primitives);
+	free(bandes);
+	bandes = NULL;
+	nb_bandes = 0;
+	free(image);
+	image = NULL;
+	actif = false;
+}
+
+bool rendu_actif(void)
+{
+	return actif;
+}
+
+void rendu_debut(const float *couleur)
+{
+	int b;
+	rendu_couleur(couleur, fond);
+	for (b = 0; b < nb_bandes; b++)
+		bandes[b].nb = 0;
+}
+
+void rendu_cercle(double x, double y, double r, const float *couleur, bool plein,
+				  double epaisseur)
+{
+	double externe = plein ? r : r + epaisseur/2.;
+	PRIMITIVE cercle = {PRIMITIVE_CERCLE, plein, {0, 0, 0}, x, y, 0., 0., r,
+						epaisseur};
+	rendu_couleur(couleur, cercle.couleur);
+	rendu_ajouter(&cercle, y - externe, y + externe);
+}
+
+void rendu_segment(double x_a, double y_a, double x_b, double y_b,
+				   const float *couleur, double largeur_trait)
+{
+	double demi = fmax(largeur_trait, LARGEUR_MIN)/2.;
+	PRIMITIVE segment = {PRIMITIVE_SEGMENT, false, {0, 0, 0}, x_a, y_a, x_b, y_b,
+						 demi, 0.};
+	rendu_couleur(couleur, segment.couleur);
+	rendu_ajouter(&segment, fmin(y_a, y_b) - demi, fmax(y_a, y_b) + demi);
+}
+
+// le fil appelant travaille aussi; sans fil supplémentaire, il fait tout
+void rendu_fin(void)
+{
+	pthread_t fils[NB_FILS_MAX];
+	bool lance[NB_FILS_MAX];
+	int i;
+
+	atomic_store(&bande_suivante, 0);
+	for (i = 1; i < nb_fils; i++)
+		lance[i] = !pthread_create(&fils[i], NULL, rendu_travailler, NULL);
+	rendu_travailler(NULL);
+	for (i = 1; i < nb_fils; i++)
+		if (lance[i])
+			pthread_join(fils[i], NULL);
+}
+
+bool rendu_ecrire(unsigned int tour)
+{
+	char nom[LONGUEUR_NOM + 16];
+	size_t taille = (size_t)largeur*hauteur*3;
+	FILE *fichier;
+	bool succes;
+
+	if (strcmp(prefixe, SORTIE_STANDARD) == 0)
+		return fwrite(image, 1, taille, stdout) == taille && !fflush(stdout);
+	snprintf(nom, sizeof(nom), "%s_%06u.ppm", prefixe, tour);
+	if (!(fichier = fopen(nom, "wb")))
+		return false;
+	fprintf(fichier, "P6\n%d %d\n255\n", largeur, hauteur);
+	succes = fwrite(image, 1, taille, fichier) == taille;
+	return !fclose(fichier) && succes;
+}
+
+// la primitive est copiée dans chaque bande que touchent ses lignes; une
+// primitive hors de l'image n'est pas enregistrée
+static void rendu_ajouter(const PRIMITIVE *primitive, double y_min, double y_max)
+{
+	int b, b_min, b_max;
+	BANDE *bande;
+
+	if (y_max < 0. || y_min >= hauteur)
+		return;
+	b_min = fmax(0., y_min)/HAUTEUR_BANDE;
+	b_max = fmin(hauteur - 1., y_max)/HAUTEUR_BANDE;
+	for (b = b_min; b <= b_max; b++)
+	{
+		bande = &bandes[b];
+		if (bande->nb == bande->capacite)
+		{
+			bande->capacite = bande->capacite ? 2*bande->capacite : 64;
+			if (!(bande->primitives = realloc(bande->primitives,
+											  bande->capacite*sizeof(PRIMITIVE))))
+				exit(EXIT_FAILURE);
+		}
+		bande->primitives[bande->nb++] = *primitive;
+	}
+}
+
+static void rendu_couleur(const float *couleur, unsigned char *octets)
+{
+	int k;
+	for (k = 0; k < 3; k++)
+		octets[k] = couleur[k]*255. + 0.5;
+}
+
+static void* rendu_travailler(void *inutile)
+{
+	int b;
+	(void)inutile;
+	while ((b = atomic_fetch_add(&bande_suivante, 1)) < nb_bandes)
+		rendu_bande(b);
+	return NULL;
+}
+
+static void rendu_bande(int b)
+{
+	int i, y_debut = b*HAUTEUR_BANDE;
+	int y_fin = y_debut + HAUTEUR_BANDE < hauteur ? y_debut + HAUTEUR_BANDE
+												   : hauteur;
+	const PRIMITIVE *primitive;
+
+	for (i = y_debut; i < y_fin; i++)
+		rendu_ligne(i, 0., largeur, fond);
+	for (i = 0; i < bandes[b].nb; i++)
+	{
+		primitive = &bandes[b].primitives[i];
+		if (primitive->type == PRIMITIVE_CERCLE)
+			rendu_cercle_bande(primitive, y_debut, y_fin);
+		else
+			rendu_segment_bande(primitive, y_debut, y_fin);
+	}
+}
+
+// un pixel est couvert si son centre est dans le disque, ou dans l'anneau
+// d'épaisseur donnée pour un cercle vide
+static void rendu_cercle_bande(const PRIMITIVE *cercle, int y_debut, int y_fin)
+{
+	int y, y_dernier;
+	double dy, demi, demi_interne;
+	double x = cercle->x_a, r = cercle->rayon;
+	double externe = cercle->plein ? r : r + cercle->epaisseur/2.;
+	double interne = cercle->plein ? 0. : r - cercle->epaisseur/2.;
+
+	// la bande voisine peut aussi contenir le cercle: chaque pixel n'est écrit
+	// que par le fil de sa bande
+	if (externe < RAYON_POINT)
+	{
+		if (x >= 0. && x < largeur && cercle->y_a >= y_debut && cercle->y_a < y_fin)
+			rendu_pixel(x, cercle->y_a, cercle->couleur);
+		return;
+	}
+	y_dernier = rendu_dernier(cercle->y_a + externe, y_fin - 1);
+	for (y = rendu_premier(cercle->y_a - externe, y_debut); y <= y_dernier; y++)
+	{
+		dy = y + 0.5 - cercle->y_a;
+		if (dy*dy > externe*externe)
+			continue;
+		demi = sqrt(externe*externe - dy*dy);
+		if (interne <= 0. || dy*dy >= interne*interne)
+		{
+			rendu_ligne(y, x - demi, x + demi, cercle->couleur);
+			continue;
+		}
+		demi_interne = sqrt(interne*interne - dy*dy);
+		rendu_ligne(y, x - demi, x - demi_interne, cercle->couleur);
+		rendu_ligne(y, x + demi_interne, x + demi, cercle->couleur);
+	}
+}
+
+// sur chaque ligne, les pixels retenus sont ceux dont le centre est à moins
+// d'une demi-largeur du segment
+static void rendu_segment_bande(const PRIMITIVE *segment, int y_debut, int y_fin)
+{
+	int x, y, x_min, x_max, y_max;
+	double dx = segment->x_b - segment->x_a, dy = segment->y_b - segment->y_a;
+	double longueur2 = dx*dx + dy*dy, t, ex, ey, r = segment->rayon;
+
+	x_min = rendu_premier(fmin(segment->x_a, segment->x_b) - r, 0);
+	x_max = rendu_dernier(fmax(segment->x_a, segment->x_b) + r, largeur - 1);
+	y_max = rendu_dernier(fmax(segment->y_a, segment->y_b) + r, y_fin - 1);
+	for (y = rendu_premier(fmin(segment->y_a, segment->y_b) - r, y_debut);
+		 y <= y_max; y++)
+	{
+		for (x = x_min; x <= x_max; x++)
+		{
+			ex = x + 0.5 - segment->x_a;
+			ey = y + 0.5 - segment->y_a;
+			t = longueur2 > 0. ? (ex*dx + ey*dy)/longueur2 : 0.;
+			t = t < 0. ? 0. : t > 1. ? 1. : t;
+			ex -= t*dx;
+			ey -= t*dy;
+			if (ex*ex + ey*ey <= r*r)
+				rendu_pixel(x, y, segment->couleur);
+		}
+	}
+}
+
+// pixels de la ligne y dont le centre est dans [x_debut, x_fin]
+static void rendu_ligne(int y, double x_debut, double x_fin,
+						const unsigned char *couleur)
+{
+	int x = rendu_premier(x_debut, 0);
+	int x_dernier = rendu_dernier(x_fin, largeur - 1);
+	unsigned char *pixel;
+
+	if (x > x_dernier)
+		return;
+	for (pixel = &image[((size_t)y*largeur + x)*3]; x <= x_dernier;
+		 x++, pixel += 3)
+	{
+		pixel[0] = couleur[0];
+		pixel[1] = couleur[1];
+		pixel[2] = couleur[2];
+	}
+}
+
+static void rendu_pixel(int x, int y, const unsigned char *couleur)
+{
+	unsigned char *pixel;
+	if (x < 0 || x >= largeur || y < 0 || y >= hauteur)
+		return;
+	pixel = &image[((size_t)y*largeur + x)*3];
+	pixel[0] = couleur[0];
+	pixel[1] = couleur[1];
+	pixel[2] = couleur[2];
+}
+
+// premier pixel, au moins min, dont le centre est après v; les conversions se
+// font après bornage, sans appel à la bibliothèque mathématique
+static int rendu_premier(double v, int min)
+{
+	int i;
+	v -= 0.5;
+	if (v <= min)
+		return min;
+	i = v;
+	return i + (i < v);
+}
+
+// dernier pixel, au plus max, dont le centre est avant v; -1 si aucun pixel
+// positif ne convient
+static int rendu_dernier(double v, int max)
+{
+	v -= 0.5;
+	if (v >= max)
+		return max;
+	return v < 0. ? -1 : (int)v;
+}
@@ -0,0 +1,82 @@
+/*!
+ \file rendu.h
+ \brief Module de rendu logiciel: les cercles et segments du dessin sont
+        rastérisés dans une image en mémoire par plusieurs fils, sans OpenGL,
+        puis écrits en PPM ou envoyés bruts à un encodeur
+ \author agent
+ \group Sylvain Pellegrini
+		Simon Gilgien
+ \version 1.0
+ \date 19 octobre 2026
+ */
+
+#ifndef RENDU_H
+#define RENDU_H
+
+#include <stdbool.h>
+
+/**
+ * \brief	Active le rendu logiciel: tant qu'il est actif, le module graphic
+ *			dessine dans l'image en mémoire au lieu de la fenêtre OpenGL.
+ * \param largeur	La largeur de l'image en pixels.
+ * \param hauteur	La hauteur de l'image en pixels.
+ * \param nb_fils	Le nombre de fils de rastérisation, au moins 1.
+ * \param prefixe	Le préfixe des fichiers PPM, "-" pour écrire les images
+ *					brutes (RGB 8 bits) sur la sortie standard.
+ * \return	Faux si la mémoire manque.
+ */
+bool rendu_ouvrir(int largeur, int hauteur, int nb_fils, const char *prefixe);
+
+/**
+ * \brief	Désactive le rendu logiciel et libère l'image.
+ */
+void rendu_fermer(void);
+
+/**
+ * \brief	Indique si le rendu logiciel est actif.
+ */
+bool rendu_actif(void);
+
+/**
+ * \brief	Commence une image: les primitives suivantes sont seulement
+ *			enregistrées, jusqu'à rendu_fin().
+ * \param fond	La couleur de fond, 3 composantes dans [0, 1].
+ */
+void rendu_debut(const float *fond);
+
+/**
+ * \brief	Enregistre un cercle. Les coordonnées sont en pixels, l'origine en
+ *			haut à gauche; un cercle de moins d'un demi-pixel de rayon colore
+ *			le pixel de son centre.
+ * \param x			Coordonnée x du centre.
+ * \param y			Coordonnée y du centre.
+ * \param r			Rayon du cercle.
+ * \param couleur	Couleur, 3 composantes dans [0, 1].
+ * \param plein		Définit si le cercle est plein ou vide.
+ * \param epaisseur	Épaisseur du trait d'un cercle vide.
+ */
+void rendu_cercle(double x, double y, double r, const float *couleur, bool plein,
+				  double epaisseur);
+
+/**
+ * \brief	Enregistre un segment, en pixels comme rendu_cercle().
+ * \param largeur	Largeur du trait.
+ */
+void rendu_segment(double x_a, double y_a, double x_b, double y_b,
+				   const float *couleur, double largeur);
+
+/**
+ * \brief	Rastérise les primitives enregistrées, dans l'ordre, par bandes
+ *			horizontales réparties entre les fils.
+ */
+void rendu_fin(void);
+
+/**
+ * \brief	Écrit l'image dans le fichier <prefixe>_<tour>.ppm, ou sur la sortie
+ *			standard.
+ * \param tour	Le numéro du tour, pour le nom du fichier.
+ * \return	Faux si l'écriture a échoué.
+ */
+bool rendu_ecrire(unsigned int tour);
+
+#endif
@@ -0,0 +1,709 @@
+/*!
+ \file repartition.c
+ \brief Module répartissant une simulation sans affichage entre des processus
+        travailleurs locaux, chacun chargé d'une bande du monde
+ \author agent
+ \group Sylvain Pellegrini
+		Simon Gilgien
+ \version 1.0
+ \date 19 octobre 2026
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <errno.h>
+#include <math.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include "arene.h"
+#include "constantes.h"
+#include "particule.h"
+#include "robot.h"
+#include "simulation.h"
+#include "repartition.h"
+
+// au-delà de cette distance, deux robots ne peuvent s'influencer pendant un tour:
+// robot_collision_correction n'arrête un robot que sur un robot qu'il touche le
+// long de son déplacement, à moins de 2*R_ROBOT + VTRAN_MAX*DELTA_T du départ.
+// Un rayon de robot de plus couvre les arrondis
+#define PORTEE				(3*R_ROBOT + VTRAN_MAX*DELTA_T)
+#define PAS_MAX				(VTRAN_MAX*DELTA_T)
+#define CAPACITE_ECARTS_MIN	1024
+// les champs de navigation (-DNAVIGATION) dépendent de la position de tous les
+// robots: chaque travailleur reçoit alors tous les robots
+#ifdef NAVIGATION
+#define HALO_COMPLET		true
+#else
+#define HALO_COMPLET		false
+#endif
+
+// proposition d'un travailleur pour l'un de ses robots: état du robot après le
+// déplacement calculé sur sa copie du monde
+typedef struct Proposition PROPOSITION;
+struct Proposition
+{
+	int robot;
+	int indice_lu;		// voir robot_deplacer_isole
+	ETAT_ROBOT etat;
+};
+
+// état retenu pour un robot, envoyé par le coordinateur
+typedef struct Releve RELEVE;
+struct Releve
+{
+	int robot;
+	ETAT_ROBOT etat;
+};
+
+// bilan d'un tour envoyé par le coordinateur à chaque travailleur, suivi de
+// nb_etats relevés, des nb_elimines particules éliminées dans l'ordre et, après
+// une attribution, des cibles de tous les robots. Le premier bilan, avant le
+// premier tour, ne contient rien
+typedef struct Bilan BILAN;
+struct Bilan
+{
+	bool fin_tour;
+	bool continuer;
+	bool attribution;
+	int nb_etats;
+	int nb_elimines;
+};
+
+typedef struct Tampon TAMPON;
+struct Tampon
+{
+	char *octets;
+	size_t taille;
+	size_t capacite;
+};
+
+// travailleur d'une bande: processus, extrémité de la paire côté coordinateur,
+// propositions du tour et bilan en préparation
+typedef struct Travailleur TRAVAILLEUR;
+struct Travailleur
+{
+	pid_t pid;
+	int socket;
+	TAMPON propositions;
+	size_t lu;
+	TAMPON bilan;
+};
+
+// robot validé pendant le tour: positions au départ, proposée par le travailleur
+// de sa bande et retenue
+typedef struct Suivi SUIVI;
+struct Suivi
+{
+	S2D depart;
+	S2D propose;
+	S2D arrivee;
+	int bande;
+	bool accepte;
+	bool deplace;		// arrivee différente de depart
+	bool ecart;			// arrivee différente de propose
+};
+
+// robots validés dont un travailleur a pu supposer une autre position que celle
+// retenue, par case de côté PORTEE dans une table de hachage chaînée. Un seau
+// d'une génération passée est vide: changer de génération vide la table
+typedef struct Ecarts ECARTS;
+struct Ecarts
+{
+	int taille;			// nombre de seaux, puissance de 2
+	int *tete;
+	unsigned int *generation;
+	unsigned int courante;
+	int *robot;
+	int *suivant;
+	int nb;
+	int capacite;
+};
+
+static int nb_bandes = 1;
+static double gauche = 0.;
+static double largeur = 0.;
+static SUIVI *suivis = NULL;
+static ECARTS ecarts = {0, NULL, NULL, 0, NULL, NULL, 0, 0};
+
+static bool repartition_lancer(TRAVAILLEUR *travailleurs, int bande);
+
+static void repartition_travailler(int socket, int bande);
+
+static bool repartition_appliquer(const TAMPON *bilan);
+
+static bool repartition_recevoir_propositions(TRAVAILLEUR *travailleurs);
+
+static bool repartition_valider(TRAVAILLEUR *travailleurs, TAMPON *elimines,
+								const int *liste, int nb_actifs);
+
+static void repartition_preparer_bilans(TRAVAILLEUR *travailleurs,
+										const int *liste, int nb_actifs);
+
+static bool repartition_envoyer_bilans(TRAVAILLEUR *travailleurs, BILAN entete,
+									   const TAMPON *elimines, const int *cibles);
+
+static bool repartition_terminer(TRAVAILLEUR *travailleurs, int nb_lances,
+								 bool succes);
+
+static int repartition_bande(double x);
+
+static bool repartition_dans_halo(double x, int bande);
+
+static bool repartition_pres_bord(double x, int bande);
+
+static bool repartition_proche(S2D a, S2D b);
+
+static bool repartition_conflit(S2D depart, int bande);
+
+static bool repartition_ecrire(int socket, const void *donnees, size_t taille);
+
+static bool repartition_lire(int socket, void *donnees, size_t taille);
+
+static bool repartition_envoyer(int socket, const TAMPON *tampon);
+
+static bool repartition_recevoir(int socket, TAMPON *tampon);
+
+static void *tampon_reserver(TAMPON *tampon, size_t taille);
+
+static void tampon_ajouter(TAMPON *tampon, const void *donnees, size_t taille);
+
+static void ecarts_preparer(int nb_robots);
+
+static void ecarts_inserer(int robot, S2D p, S2D q, S2D r);
+
+static void ecarts_ajouter(int robot, S2D p);
+
+static unsigned int ecarts_seau(long cx, long cy);
+
+// même boucle que simulation_executer, en mode standard; les travailleurs sont
+// des fils créés après l'attribution initiale, qui partent donc du même état, y
+// compris celui de rand() dont ils rejouent la décomposition
+bool repartition_executer(int nb_travailleurs, unsigned int nb_tours_max,
+						  unsigned int *p_tours, double *p_taux)
+{
+	TRAVAILLEUR *travailleurs;
+	TAMPON elimines = {NULL, 0, 0};
+	BILAN entete = {false, false, false, 0, 0};
+	const int *liste;
+	int *cibles;
+	int w, nb_actifs, nb_lances = 0, nb_robots = robot_nb_robots();
+	double Td = 0., Si, Sd = 0.;
+	unsigned int tours = 0;
+	bool succes = true;
+
+	nb_bandes = nb_travailleurs;
+	gauche = -simulation_dmax();
+	largeur = 2.*simulation_dmax()/nb_bandes;
+	if (!(travailleurs = calloc(nb_bandes, sizeof(TRAVAILLEUR))) ||
+		!(suivis = realloc(suivis, (nb_robots + 1)*sizeof(SUIVI))) ||
+		!(cibles = malloc((nb_robots + 1)*sizeof(int))))
+		exit(EXIT_FAILURE);
+	ecarts_preparer(nb_robots);
+	simulation_set_evenementiel(false);
+	but_initial();
+	Si = somme_des_energies();
+	for (w = 0; w < nb_bandes && succes; w++)
+	{
+		if ((succes = repartition_lancer(travailleurs, w)))
+			nb_lances++;
+	}
+	entete.continuer = Si > 0 && Td < CENT_POUR_CENT && tours < nb_tours_max;
+	repartition_preparer_bilans(travailleurs, NULL, 0);
+	succes = succes && repartition_envoyer_bilans(travailleurs, entete, &elimines,
+												  cibles);
+	while (succes && entete.continuer)
+	{
+		arene_reinitialiser();
+		nb_actifs = robot_actifs(&liste);
+		if (!(succes = repartition_recevoir_propositions(travailleurs)) ||
+			!(succes = repartition_valider(travailleurs, &elimines, liste, nb_actifs)))
+			break;
+		repartition_preparer_bilans(travailleurs, liste, nb_actifs);
+		if ((entete.attribution = update_nb_part()))
+		{
+			set_robot_occupe();
+			attribution_but();
+			robot_exporter_cibles(cibles);
+		}
+		// les travailleurs décomposent et commencent le tour suivant pendant que
+		// le coordinateur décompose et décide de l'arrêt
+		entete.fin_tour = true;
+		if (!(succes = repartition_envoyer_bilans(travailleurs, entete, &elimines,
+												  cibles)))
+			break;
+		decomposition();
+		update_taux_decontamination(&Td, &Si, &Sd);
+		tours++;
+		if (Si > 0 && Td < CENT_POUR_CENT && tours < nb_tours_max)
+			continue;
+		// les propositions du tour commencé sont ignorées
+		entete.continuer = false;
+		entete.fin_tour = false;
+		entete.attribution = false;
+		repartition_preparer_bilans(travailleurs, NULL, 0);
+		succes = repartition_recevoir_propositions(travailleurs) &&
+				 repartition_envoyer_bilans(travailleurs, entete, &elimines, cibles);
+	}
+	succes = repartition_terminer(travailleurs, nb_lances, succes);
+	*p_tours = tours;
+	*p_taux = Td;
+	for (w = 0; w < nb_bandes; w++)
+	{
+		free(travailleurs[w].propositions.octets);
+		free(travailleurs[w].bilan.octets);
+	}
+	free(travailleurs);
+	free(elimines.octets);
+	free(cibles);
+	return succes;
+}
+
+// le fils ferme les sockets des travailleurs lancés avant lui, hérités du
+// coordinateur: ils ne verraient sinon pas la fin de celui-ci
+static bool repartition_lancer(TRAVAILLEUR *travailleurs, int bande)
+{
+	int paire[2], w;
+	pid_t pid;
+
+	if (socketpair(AF_UNIX, SOCK_STREAM, 0, paire) < 0)
+	{
+		perror("socketpair");
+		return false;
+	}
+	// sans quoi le fils hériterait des sorties en attente du coordinateur
+	fflush(stdout);
+	if ((pid = fork()) < 0)
+	{
+		perror("fork");
+		close(paire[0]);
+		close(paire[1]);
+		return false;
+	}
+	if (pid == 0)
+	{
+		close(paire[0]);
+		for (w = 0; w < bande; w++)
+			close(travailleurs[w].socket);
+		repartition_travailler(paire[1], bande);
+	}
+	close(paire[1]);
+	travailleurs[bande].pid = pid;
+	travailleurs[bande].socket = paire[0];
+	return true;
+}
+
+// les robots de la bande sont déplacés par indice croissant sur la copie du
+// monde: ceux des autres bandes y sont à leur position de départ, et aucune
+// particule n'est éliminée
+static void repartition_travailler(int socket, int bande)
+{
+	TAMPON tampon = {NULL, 0, 0};
+	PROPOSITION proposition;
+	const int *liste;
+	int k, i, nb_actifs;
+
+	while (repartition_recevoir(socket, &tampon))
+	{
+		arene_reinitialiser();
+		if (!repartition_appliquer(&tampon))
+		{
+			close(socket);
+			_exit(EXIT_SUCCESS);
+		}
+		tampon.taille = 0;
+		nb_actifs = robot_actifs(&liste);
+		for (k = 0; k < nb_actifs; k++)
+		{
+			i = liste[k];
+			if (repartition_bande(robot_position(i+1).centre.x) != bande)
+				continue;
+			proposition.robot = i;
+			proposition.indice_lu = robot_deplacer_isole(i);
+			robot_exporter_etat(i, &proposition.etat);
+			tampon_ajouter(&tampon, &proposition, sizeof(PROPOSITION));
+		}
+		if (!repartition_envoyer(socket, &tampon))
+			break;
+	}
+	_exit(EXIT_FAILURE);
+}
+
+// rejoue sur la copie du travailleur la fin du tour validée par le coordinateur;
+// retourne faux si la simulation est terminée
+static bool repartition_appliquer(const TAMPON *bilan)
+{
+	BILAN entete;
+	RELEVE releve;
+	const char *octets = bilan->octets + sizeof(BILAN);
+	int k, i;
+
+	memcpy(&entete, bilan->octets, sizeof(BILAN));
+	if (!entete.continuer)
+		return false;
+	for (k = 0; k < entete.nb_etats; k++)
+	{
+		memcpy(&releve, octets, sizeof(RELEVE));
+		robot_importer_etat(releve.robot, &releve.etat);
+		octets += sizeof(RELEVE);
+	}
+	for (k = 0; k < entete.nb_elimines; k++)
+	{
+		memcpy(&i, octets, sizeof(int));
+		eliminer_particule(i);
+		octets += sizeof(int);
+	}
+	if (entete.attribution)
+		robot_affecter_cibles((const int *)octets);
+	if (entete.fin_tour)
+		decomposition();
+	return true;
+}
+
+static bool repartition_recevoir_propositions(TRAVAILLEUR *travailleurs)
+{
+	for (int w = 0; w < nb_bandes; w++)
+	{
+		if (!repartition_recevoir(travailleurs[w].socket,
+								  &travailleurs[w].propositions))
+			return false;
+	}
+	return true;
+}
+
+// un déplacement proposé est retenu si aucun robot validé avant lui n'a été
+// supposé par son travailleur à une autre position que la sienne près de lui, et
+// si aucune particule qu'il a lue n'a changé d'indice; sinon il est refait ici,
+// sur l'état exact. Une particule éliminée décale les indices qui la suivent
+static bool repartition_valider(TRAVAILLEUR *travailleurs, TAMPON *elimines,
+								const int *liste, int nb_actifs)
+{
+	PROPOSITION proposition;
+	TRAVAILLEUR *travailleur;
+	SUIVI *suivi;
+	int w, k, i, elimine, indice_min = INT_MAX;
+
+	elimines->taille = 0;
+	ecarts.courante++;
+	ecarts.nb = 0;
+	for (w = 0; w < nb_bandes; w++)
+		travailleurs[w].lu = 0;
+	for (k = 0; k < nb_actifs; k++)
+	{
+		i = liste[k];
+		suivi = &suivis[i];
+		suivi->depart = robot_position(i+1).centre;
+		suivi->bande = repartition_bande(suivi->depart.x);
+		travailleur = &travailleurs[suivi->bande];
+		if (travailleur->lu + sizeof(PROPOSITION) > travailleur->propositions.taille)
+			return false;
+		memcpy(&proposition, travailleur->propositions.octets + travailleur->lu,
+			   sizeof(PROPOSITION));
+		if (proposition.robot != i)
+			return false;
+		suivi->propose = proposition.etat.position;
+		suivi->accepte = proposition.indice_lu < indice_min &&
+						 !repartition_conflit(suivi->depart, suivi->bande);
+		if (suivi->accepte)
+			robot_importer_etat(i, &proposition.etat);
+		else
+			robot_deplacer_isole(i);
+		travailleur->lu += sizeof(PROPOSITION);
+		if ((elimine = robot_decontaminer(i)))
+		{
+			tampon_ajouter(elimines, &elimine, sizeof(int));
+			if (elimine < indice_min)
+				indice_min = elimine;
+		}
+		suivi->arrivee = robot_position(i+1).centre;
+		suivi->deplace = suivi->arrivee.x != suivi->depart.x ||
+						 suivi->arrivee.y != suivi->depart.y;
+		suivi->ecart = suivi->arrivee.x != suivi->propose.x ||
+					   suivi->arrivee.y != suivi->propose.y;
+		if (suivi->ecart ||
+			(suivi->deplace && repartition_pres_bord(suivi->depart.x, suivi->bande)))
+			ecarts_inserer(i, suivi->depart, suivi->propose, suivi->arrivee);
+	}
+	for (w = 0; w < nb_bandes; w++)
+	{
+		if (travailleurs[w].lu != travailleurs[w].propositions.taille)
+			return false;
+	}
+	return true;
+}
+
+// un travailleur reçoit les robots validés qui partent de sa bande ou de son
+// halo ou y arrivent, sauf les siens acceptés tels quels: sa copie des robots
+// hors de portée de sa bande peut être ancienne
+static void repartition_preparer_bilans(TRAVAILLEUR *travailleurs,
+										const int *liste, int nb_actifs)
+{
+	TAMPON *bilan;
+	SUIVI *suivi;
+	RELEVE releve;
+	int w, k, i;
+
+	for (w = 0; w < nb_bandes; w++)
+	{
+		bilan = &travailleurs[w].bilan;
+		bilan->taille = 0;
+		tampon_reserver(bilan, sizeof(BILAN));
+		for (k = 0; k < nb_actifs; k++)
+		{
+			i = liste[k];
+			suivi = &suivis[i];
+			if ((suivi->bande == w && suivi->accepte) ||
+				!(HALO_COMPLET || repartition_dans_halo(suivi->depart.x, w) ||
+				  repartition_dans_halo(suivi->arrivee.x, w)))
+				continue;
+			releve.robot = i;
+			robot_exporter_etat(i, &releve.etat);
+			tampon_ajouter(bilan, &releve, sizeof(RELEVE));
+		}
+	}
+}
+
+static bool repartition_envoyer_bilans(TRAVAILLEUR *travailleurs, BILAN entete,
+									   const TAMPON *elimines, const int *cibles)
+{
+	TAMPON *bilan;
+	int w;
+
+	for (w = 0; w < nb_bandes; w++)
+	{
+		bilan = &travailleurs[w].bilan;
+		entete.nb_etats = (bilan->taille - sizeof(BILAN))/sizeof(RELEVE);
+		entete.nb_elimines = entete.fin_tour ? elimines->taille/sizeof(int) : 0;
+		memcpy(bilan->octets, &entete, sizeof(BILAN));
+		if (entete.fin_tour)
+			tampon_ajouter(bilan, elimines->octets, elimines->taille);
+		if (entete.attribution)
+			tampon_ajouter(bilan, cibles, robot_nb_robots()*sizeof(int));
+		if (!repartition_envoyer(travailleurs[w].socket, bilan))
+			return false;
+	}
+	return true;
+}
+
+// après un échec, les travailleurs encore en vie sont arrêtés
+static bool repartition_terminer(TRAVAILLEUR *travailleurs, int nb_lances,
+								 bool succes)
+{
+	int w, statut;
+
+	for (w = 0; w < nb_lances; w++)
+	{
+		if (!succes)
+			kill(travailleurs[w].pid, SIGKILL);
+		close(travailleurs[w].socket);
+	}
+	for (w = 0; w < nb_lances; w++)
+	{
+		if (waitpid(travailleurs[w].pid, &statut, 0) < 0 || !WIFEXITED(statut) ||
+			WEXITSTATUS(statut) != EXIT_SUCCESS)
+			succes = false;
+	}
+	return succes;
+}
+
+// les robots sortis du monde restent dans la bande du bord
+static int repartition_bande(double x)
+{
+	int bande = (int)floor((x - gauche)/largeur);
+
+	if (bande < 0)
+		return 0;
+	return bande < nb_bandes ? bande : nb_bandes - 1;
+}
+
+static bool repartition_dans_halo(double x, int bande)
+{
+	return (bande == 0 || x >= gauche + bande*largeur - PORTEE) &&
+		   (bande == nb_bandes - 1 || x < gauche + (bande + 1)*largeur + PORTEE);
+}
+
+// seul un robot parti à moins de PORTEE + PAS_MAX d'une frontière peut
+// influencer un robot d'une autre bande
+static bool repartition_pres_bord(double x, int bande)
+{
+	return (bande > 0 && x < gauche + bande*largeur + PORTEE + PAS_MAX) ||
+		   (bande < nb_bandes - 1 &&
+			x >= gauche + (bande + 1)*largeur - PORTEE - PAS_MAX);
+}
+
+static bool repartition_proche(S2D a, S2D b)
+{
+	return (a.x - b.x)*(a.x - b.x) + (a.y - b.y)*(a.y - b.y) < PORTEE*PORTEE;
+}
+
+// le travailleur d'un robot d'une autre bande l'a supposé à son départ, celui
+// d'un robot de la même bande à la position qu'il a proposée
+static bool repartition_conflit(S2D depart, int bande)
+{
+	long cx = (long)floor(depart.x/PORTEE), cy = (long)floor(depart.y/PORTEE);
+	long dx, dy;
+	unsigned int seau;
+	int e;
+	SUIVI *suivi;
+
+	for (dx = -1; dx <= 1; dx++)
+	{
+		for (dy = -1; dy <= 1; dy++)
+		{
+			seau = ecarts_seau(cx + dx, cy + dy);
+			if (ecarts.generation[seau] != ecarts.courante)
+				continue;
+			for (e = ecarts.tete[seau]; e >= 0; e = ecarts.suivant[e])
+			{
+				suivi = &suivis[ecarts.robot[e]];
+				if (suivi->bande != bande ? suivi->deplace &&
+						(repartition_proche(depart, suivi->depart) ||
+						 repartition_proche(depart, suivi->arrivee))
+					: suivi->ecart &&
+						(repartition_proche(depart, suivi->propose) ||
+						 repartition_proche(depart, suivi->arrivee)))
+					return true;
+			}
+		}
+	}
+	return false;
+}
+
+static bool repartition_ecrire(int socket, const void *donnees, size_t taille)
+{
+	const char *octets = donnees;
+	ssize_t n;
+
+	while (taille > 0)
+	{
+		// un travailleur arrêté ne doit pas tuer le coordinateur par SIGPIPE
+		if ((n = send(socket, octets, taille, MSG_NOSIGNAL)) < 0)
+		{
+			if (errno == EINTR)
+				continue;
+			return false;
+		}
+		octets += n;
+		taille -= n;
+	}
+	return true;
+}
+
+static bool repartition_lire(int socket, void *donnees, size_t taille)
+{
+	char *octets = donnees;
+	ssize_t n;
+
+	while (taille > 0)
+	{
+		if ((n = read(socket, octets, taille)) < 0 && errno == EINTR)
+			continue;
+		if (n <= 0)
+			return false;
+		octets += n;
+		taille -= n;
+	}
+	return true;
+}
+
+// un message est précédé de sa taille
+static bool repartition_envoyer(int socket, const TAMPON *tampon)
+{
+	return repartition_ecrire(socket, &tampon->taille, sizeof(size_t)) &&
+		   repartition_ecrire(socket, tampon->octets, tampon->taille);
+}
+
+static bool repartition_recevoir(int socket, TAMPON *tampon)
+{
+	size_t taille;
+
+	if (!repartition_lire(socket, &taille, sizeof(size_t)))
+		return false;
+	tampon->taille = 0;
+	return repartition_lire(socket, tampon_reserver(tampon, taille), taille);
+}
+
+static void *tampon_reserver(TAMPON *tampon, size_t taille)
+{
+	void *place;
+
+	if (tampon->taille + taille > tampon->capacite)
+	{
+		tampon->capacite = 2*(tampon->taille + taille);
+		if (!(tampon->octets = realloc(tampon->octets, tampon->capacite)))
+			exit(EXIT_FAILURE);
+	}
+	place = tampon->octets + tampon->taille;
+	tampon->taille += taille;
+	return place;
+}
+
+static void tampon_ajouter(TAMPON *tampon, const void *donnees, size_t taille)
+{
+	if (taille)
+		memcpy(tampon_reserver(tampon, taille), donnees, taille);
+}
+
+static void ecarts_preparer(int nb_robots)
+{
+	int taille = CAPACITE_ECARTS_MIN;
+
+	while (taille < 4*nb_robots)
+		taille *= 2;
+	if (taille != ecarts.taille)
+	{
+		ecarts.taille = taille;
+		if (!(ecarts.tete = realloc(ecarts.tete, taille*sizeof(int))) ||
+			!(ecarts.generation = realloc(ecarts.generation,
+										  taille*sizeof(unsigned int))))
+			exit(EXIT_FAILURE);
+	}
+	memset(ecarts.generation, 0, taille*sizeof(unsigned int));
+	ecarts.courante = 0;
+	ecarts.nb = 0;
+}
+
+// un robot est rangé dans la case de chacune de ses positions
+static void ecarts_inserer(int robot, S2D p, S2D q, S2D r)
+{
+	long px = (long)floor(p.x/PORTEE), py = (long)floor(p.y/PORTEE);
+	long qx = (long)floor(q.x/PORTEE), qy = (long)floor(q.y/PORTEE);
+	long rx = (long)floor(r.x/PORTEE), ry = (long)floor(r.y/PORTEE);
+
+	ecarts_ajouter(robot, p);
+	if (qx != px || qy != py)
+		ecarts_ajouter(robot, q);
+	if ((rx != px || ry != py) && (rx != qx || ry != qy))
+		ecarts_ajouter(robot, r);
+}
+
+static void ecarts_ajouter(int robot, S2D p)
+{
+	unsigned int seau = ecarts_seau((long)floor(p.x/PORTEE), (long)floor(p.y/PORTEE));
+
+	if (ecarts.nb == ecarts.capacite)
+	{
+		ecarts.capacite = ecarts.capacite ? 2*ecarts.capacite : CAPACITE_ECARTS_MIN;
+		if (!(ecarts.robot = realloc(ecarts.robot, ecarts.capacite*sizeof(int))) ||
+			!(ecarts.suivant = realloc(ecarts.suivant, ecarts.capacite*sizeof(int))))
+			exit(EXIT_FAILURE);
+	}
+	if (ecarts.generation[seau] != ecarts.courante)
+	{
+		ecarts.generation[seau] = ecarts.courante;
+		ecarts.tete[seau] = -1;
+	}
+	ecarts.robot[ecarts.nb] = robot;
+	ecarts.suivant[ecarts.nb] = ecarts.tete[seau];
+	ecarts.tete[seau] = ecarts.nb++;
+}
+
+static unsigned int ecarts_seau(long cx, long cy)
+{
+	return ((unsigned int)cx*73856093u ^ (unsigned int)cy*19349663u) &
+		   (unsigned int)(ecarts.taille - 1);
+}
@@ -0,0 +1,38 @@
+/*!
+ \file repartition.h
+ \brief Module répartissant une simulation sans affichage entre des processus
+        travailleurs locaux, chacun chargé d'une bande du monde
+ \author agent
+ \group Sylvain Pellegrini
+		Simon Gilgien
+ \version 1.0
+ \date 19 octobre 2026
+ */
+
+#ifndef REPARTITION_H
+#define REPARTITION_H
+
+#include <stdbool.h>
+
+/**
+ * \brief	Simule la situation chargée en mode standard, jusqu'à décontamination
+ *			complète ou nb_tours_max tours. Le monde est partagé en
+ *			nb_travailleurs bandes verticales de même largeur, chacune confiée à
+ *			un processus travailleur qui déplace les robots partis de sa bande en
+ *			voyant ceux des bandes voisines proches de la frontière. Le
+ *			coordinateur, relié à chacun par une paire de sockets Unix, valide
+ *			les déplacements par indice croissant, refait ceux qu'un robot d'une
+ *			autre bande ou une particule éliminée a rendus faux, attribue les
+ *			buts et calcule le taux de décontamination. Le résultat et l'état
+ *			final sont ceux d'une exécution en un seul processus.
+ * \param nb_travailleurs	Le nombre de travailleurs, >= 1.
+ * \param nb_tours_max		Le nombre maximal de tours.
+ * \param p_tours			Reçoit le nombre de tours simulés.
+ * \param p_taux			Reçoit le taux de décontamination atteint.
+ * \return	Faux si un travailleur n'a pu être lancé ou s'est arrêté avant la
+ *			fin; l'état simulé est alors perdu.
+ */
+bool repartition_executer(int nb_travailleurs, unsigned int nb_tours_max,
+						  unsigned int *p_tours, double *p_taux);
+
+#endif
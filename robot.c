@@ -12,28 +12,138 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <assert.h>
+#include <limits.h>
 #include <math.h>
+#include "arene.h"
 #include "constantes.h"
+#include "ecriture.h"
 #include "error.h"
+#include "grille.h"
+#include "navigation.h"
 #include "particule.h"
 #include "robot.h"
 
 #define EPAISSEUR_ROBOT		2
-#define NB_COORD			2
-#define RAYON_PARTICULE		1
-#define ID_PARTICULE		0
 #define RAYON_CENTRE		0.1
+#define AUCUNE_ECHEANCE		-1
+#define VOL_LIBRE_MIN		2
+#define CAPACITE_CONTACTS_MIN	16
+#define ARRETS_BLOCAGE		4
+#define ARRET_AUCUN			0
+#define ARRET_ROBOT			1
+#define ARRET_PARTICULE		2
+// champs de navigation autour des cibles visées par plusieurs robots, activés à
+// la compilation (-DNAVIGATION)
+#ifdef NAVIGATION
+#define NAVIGATION_ACTIVE	true
+#else
+#define NAVIGATION_ACTIVE	false
+#endif
+#define NAVIGATION_ROBOTS_MIN	2
 
 typedef struct Robot ROBOT;
 struct Robot
 {
     bool occupe;
     bool manual;
-    double vrot;
-    double vtrans;
+    int place_manuel;	// place dans manuels, -1 pour un robot automatique
+    REEL vrot;
+    REEL vtrans;
 	C2D position;
-	double angle;
+	REEL angle;
 	int particule_cible;
+	// trajet en cours: parcours tours de rotation sur place ou pas en ligne
+	// droite vers le point but, depuis l'état ancre. L'état d'un robot sur son
+	// trajet est toujours recalculé depuis l'ancre par robot_etat_trajet, dans
+	// la boucle standard comme en vol libre
+	S2D ancre;
+	REEL angle_ancre;
+	REEL rotation;
+	S2D pas;
+	S2D but;
+	int parcours;
+	// mode évènementiel: prochain tour où le robot doit être traité et, en vol
+	// libre, tour où son trajet aurait été au parcours 0 et particule cible
+	int echeance;
+	bool vol;
+	int tick_base;
+	C2D cible;
+	// progrès d'un robot automatique vers sa cible: plus petite distance
+	// atteinte et arrêts subis, aligné sur son but, depuis le dernier 
+	// rapprochement. Un robot bloqué garde sa cible malgré les contacts et, 
+	// si un robot l'arrête, le longe du côté cote jusqu'à être plus proche de
+	// sa cible qu'au blocage
+	REEL distance_min;
+	int arrets;
+	int arret;			// cause de l'arrêt au dernier déplacement
+	REEL normale;		// direction du dernier robot qui l'a arrêté
+	bool bloque;
+	int cote;			// 0 pour garder le cap sur la cible
+	REEL distance_blocage;
+};
+
+// balayage d'un déplacement contre les particules d'une zone: premier instant
+// de contact et indice de la particule touchée (0 si aucune)
+typedef struct Balayage BALAYAGE;
+struct Balayage
+{
+	C2D depart;
+	S2D depl;
+	double t_impact;
+	int particule;
+};
+
+// arbre kd implicite des robots libres, construit à chaque attribution: le robot
+// médian de chaque intervalle [debut, fin) de ordre sépare les autres selon x ou
+// y en alternance. Un nœud est repéré par la place de son robot médian et garde
+// la boîte englobante et le nombre de robots encore libres de son sous-arbre.
+typedef struct Arbre ARBRE;
+struct Arbre
+{
+	int *ordre;
+	int *place;
+	int *libres;
+	S2D *coin_min;
+	S2D *coin_max;
+};
+
+// recherche du robot sous un point
+typedef struct Choix CHOIX;
+struct Choix
+{
+	S2D point;
+	int robot;
+};
+
+// robots dont le rectangle de la grille touche une zone, candidats au contact
+// d'un corps; leurs cercles sont rangés en tableaux séparés pour être testés par
+// lots avec util_collision_lot
+typedef struct Contacts CONTACTS;
+struct Contacts
+{
+	int exclu;		// robot qui cherche ses contacts, -1 pour une particule
+	int nb;
+	int capacite;
+	int *robots;
+	REEL *x;
+	REEL *y;
+	REEL *r;
+};
+
+// évènement de la file de priorité: le robot doit être traité au tour echeance
+typedef struct Evenement EVENEMENT;
+struct Evenement
+{
+	int echeance;
+	int robot;
+};
+
+// tableaux d'un instantané transmis aux fils qui formatent les lignes du fichier
+typedef struct Sauvegarde SAUVEGARDE;
+struct Sauvegarde
+{
+	const C2D *cercles;
+	const double *angles;
 };
 
 static COULEUR couleur_robot =  {0., 0., 0.};
@@ -41,11 +151,81 @@ static COULEUR couleur_centre = {1., 0., 0.};
 static ROBOT* tab = NULL;
 static int nb = 0;
 
+static bool evenementiel = false;
+static int tick = 0;
+static int nb_part_connu = 0;
+static EVENEMENT *tas = NULL;
+static int taille_tas = 0;
+static int capacite_tas = 0;
+static ARBRE arbre = {NULL, NULL, NULL, NULL, NULL};
+static CONTACTS contacts = {-1, 0, 0, NULL, NULL, NULL, NULL};
+// statistiques des corrections de déplacement depuis le chargement des robots
+static unsigned long nb_candidats = 0;
+static unsigned long nb_arrets = 0;
+static unsigned long nb_chevauchements = 0;
+// particule heurtée au dernier appel de robot_collision_correction, 0 si aucune
+static int particule_heurtee = 0;
+// robots détectés bloqués et robots débloqués depuis le chargement
+static unsigned long nb_blocages = 0;
+static unsigned long nb_recuperes = 0;
+// robots contrôlés à la main, sans ordre
+static int *manuels = NULL;
+static int nb_manuels = 0;
+static int capacite_manuels = 0;
+// robots traités par la boucle standard, par indice croissant; refaite au tour
+// suivant un changement d'attribution ou de sélection
+static int *actifs = NULL;
+static int nb_actifs = 0;
+static bool actifs_perimes = true;
+
+static void robot_planifier(int i, int echeance);
+static void robot_prevoir(int i);
+static void robot_replanifier(int dernier);
+static void robot_synchroniser(int i);
+static void robot_envoler(int i);
+static void robot_arreter(int i);
+static void robot_etat_trajet(int i, int parcours, S2D *p_centre, REEL *p_angle);
+static bool robot_sur_trajet(int i);
+static void robot_commencer_trajet(int i, double angle, double rotation, S2D pas,
+								   S2D but);
+static void robot_quitter_trajet(int i);
+static C2D robot_cercle(int i);
+static bool robot_vol_libre(int i);
+static void robot_zone_balayage(BALAYAGE *balayage, S2D *p_min, S2D *p_max);
+static void robot_balayer_particule(int indice, C2D cercle, void *donnees);
+static bool tas_avant(EVENEMENT a, EVENEMENT b);
+static void tas_inserer(EVENEMENT e);
+static EVENEMENT tas_extraire(void);
+static double robot_coord(int i, int axe);
+static void arbre_construire(void);
+static void arbre_construire_noeud(int debut, int fin, int axe);
+static void arbre_selectionner(int debut, int fin, int k, int axe);
+static void arbre_retirer(int robot);
+static void arbre_chercher(int debut, int fin, int axe, C2D particule,
+						   double *p_temps_min, int *p_robot_min);
+static void robot_oublier_progres(int i);
+static void robot_suivre_progres(int i, S2D cible);
+static void robot_signaler_arret(int i);
+static S2D robot_contournement(int i);
+static void robot_indexer(int i);
+static void robot_choisir_candidat(int id, void *donnees);
+static void robot_chercher_contacts(int exclu, C2D zone);
+static void robot_ajouter_contact(int id, void *donnees);
+static bool robot_actif(int i);
+static void robot_rafraichir_actifs(void);
+static void robot_construire_champs(void);
+static bool robot_masque(int i, C2D cible);
+static int robot_formater_ligne(char *texte, int i, const void *donnees);
+
 void robot_set_nombre(int nb_robots)
 {
 	assert(nb_robots >=0);
 	if(nb_robots >0)
+	{
 		tab = realloc(tab, nb_robots*sizeof(ROBOT));
+		if (!(actifs = realloc(actifs, nb_robots*sizeof(int))))
+			exit(EXIT_FAILURE);
+	}
 	else
 	{
 		if(tab)
@@ -53,6 +233,16 @@ void robot_set_nombre(int nb_robots)
 		tab = NULL;
 	}
 	nb = nb_robots;
+	taille_tas = 0;
+	nb_blocages = 0;
+	nb_recuperes = 0;
+	nb_manuels = 0;
+	actifs_perimes = true;
+	nb_candidats = 0;
+	nb_arrets = 0;
+	nb_chevauchements = 0;
+	grille_vider();
+	navigation_vider();
 }
 
 void robot_set_robot(int i, S2D pos, double angle)
@@ -66,22 +256,28 @@ void robot_set_robot(int i, S2D pos, double angle)
     tab[i-1].vrot = VROT_MAX;
     tab[i-1].vtrans = VTRAN_MAX;
     tab[i-1].manual = false;
+    tab[i-1].place_manuel = -1;
+    tab[i-1].echeance = AUCUNE_ECHEANCE;
+    tab[i-1].vol = false;
+    robot_quitter_trajet(i-1);
+    robot_oublier_progres(i-1);
+    actifs_perimes = true;
+    robot_indexer(i-1);
+    if(evenementiel)
+		robot_planifier(i-1, tick);
 }	
 
-void robot_ecrire_fichier(FILE* fichier)
+void robot_ecrire_fichier(FILE* fichier, int nb_robots, const C2D *cercles,
+						  const double *angles)
 {
-	int i;
+	SAUVEGARDE sauvegarde = {cercles, angles};
 	
-	fprintf(fichier, "# Fichier généré\n#\n%d\n", nb);
+	fprintf(fichier, "# Fichier généré\n#\n%d\n", nb_robots);
 	
-	if(nb)
+	if(nb_robots)
 	{
-		for(i=0; i<nb; i++)
-		{
-			fprintf(fichier, "\t%g %g %g\n", tab[i].position.centre.x, 
-											 tab[i].position.centre.y,
-											 tab[i].angle);
-		}
+		ecriture_lignes(fichier, nb_robots, 3*ECRITURE_REEL_MAX + 2,
+						robot_formater_ligne, &sauvegarde);
 		fprintf(fichier, "FIN_LISTE\n");
 	}	
 }
@@ -94,67 +290,100 @@ int robot_nb_robots(void)
 C2D robot_position(int i)
 {
 	assert(0<=i && i <=nb);
+	robot_synchroniser(i-1);
 	return tab[i-1].position;
 }
 
 double robot_orientation(int i)
 {
 	assert(0<i && i <= nb);
+	robot_synchroniser(i-1);
 	return tab[i-1].angle;
 }
 
+int robot_particule_cible(int i)
+{
+	assert(0<i && i <= nb);
+	return tab[i-1].particule_cible;
+}
+
 void robot_dessiner(void)
 {
 	int i;
-	S2D centre;
     for(i =1; i<=nb; i++)
+		robot_dessiner_pose(robot_position(i).centre, robot_orientation(i),
+							robot_manual(i-1));
+}
+
+void robot_exporter(C2D *cercles, double *angles, bool *manuels)
+{
+	int i;
+	for(i = 0; i < nb; i++)
 	{
-		centre = robot_position(i).centre;
-		if (robot_manual(i-1))
-		{
-			util_dessiner_cercle(robot_position(i), couleur_centre, false,
-							 EPAISSEUR_ROBOT);
-		}
-		else
-		{
-			util_dessiner_cercle(robot_position(i), couleur_robot, false,
-								EPAISSEUR_ROBOT);
-		}
-		util_dessiner_segment(centre,
-							  util_deplacement(centre, robot_orientation(i), R_ROBOT),
-							  couleur_robot, EPAISSEUR_ROBOT);
-		C2D point_central = {centre, RAYON_CENTRE};
-		util_dessiner_cercle(point_central, couleur_centre, true, EPAISSEUR_ROBOT);
+		robot_synchroniser(i);
+		cercles[i] = tab[i].position;
+		angles[i]  = tab[i].angle;
+		manuels[i] = tab[i].manual;
 	}
 }
 
+void robot_dessiner_pose(S2D centre, double angle, bool manuel)
+{
+	C2D cercle = {centre, R_ROBOT};
+	C2D point_central = {centre, RAYON_CENTRE};
+
+	if (!util_visible(cercle))
+		return;
+	util_dessiner_cercle(cercle, manuel ? couleur_centre : couleur_robot, false,
+						 EPAISSEUR_ROBOT);
+	util_dessiner_segment(centre, util_deplacement(centre, angle, R_ROBOT),
+						  couleur_robot, EPAISSEUR_ROBOT);
+	util_dessiner_cercle(point_central, couleur_centre, true, EPAISSEUR_ROBOT);
+}
+
+// le robot signalé est celui de plus petit indice
 bool robot_collision(int i)
 {
 	assert(0<i && i<=nb);
-	int j;
+	int j, k, premier = -1;
 
-	for (j=1; j < i; j++)
+	robot_chercher_contacts(i-1, tab[i-1].position);
+	for (j=0; j < contacts.nb &&
+			  (k = util_collision_lot(tab[i-1].position, &contacts.x[j],
+									  &contacts.y[j], &contacts.r[j],
+									  contacts.nb-j)) >= 0; j+=k+1)
 	{
-		if (robot_collision_r_r(j, i))
-		{
-			error_collision(ROBOT_ROBOT, j, i);
-			return true;
-		}
+		if (contacts.robots[j+k] < i-1 &&
+			(premier < 0 || contacts.robots[j+k] < premier))
+			premier = contacts.robots[j+k];
+	}
+	if (premier >= 0)
+	{
+		error_collision(ROBOT_ROBOT, premier+1, i);
+		return true;
 	}
 	return false;
 }
 
+// le robot signalé est celui de plus grand indice
 bool robot_collision_particule(int i_part)
 {
-	int j;
+	C2D particule = particule_position(i_part);
+	int j, k, dernier = -1;
 	
-	for (j = nb; j > 0; j--)
+	robot_chercher_contacts(-1, particule);
+	for (j=0; j < contacts.nb &&
+			  (k = util_collision_lot(particule, &contacts.x[j], &contacts.y[j],
+									  &contacts.r[j], contacts.nb-j)) >= 0;
+		 j+=k+1)
 	{
-		if(robot_collision_r_p(j, i_part))
-		{
-			error_collision(ROBOT_PARTICULE, j, i_part);
-			return true;
-		}
+		if (contacts.robots[j+k] > dernier)
+			dernier = contacts.robots[j+k];
+	}
+	if (dernier >= 0)
+	{
+		error_collision(ROBOT_PARTICULE, dernier+1, i_part);
+		return true;
 	}
 	return false;
 }
@@ -183,30 +412,16 @@ void set_robot_occupe(void)
     {
         tab[i].occupe=false;
         tab[i].particule_cible=-1;
+        robot_oublier_progres(i);
     }
-}
-
-void tri_particule(int taille, double tableau[NB_COORD][taille])
-{
-    int i, j;
-    for (i = 1; i < taille; ++i) {
-        double rayon = tableau[RAYON_PARTICULE][i];
-        double indice = tableau[ID_PARTICULE][i];
-        for (j = i; j > 0 && tableau[RAYON_PARTICULE][j-1] > rayon; j--)
-        {
-            tableau[RAYON_PARTICULE][j] = tableau[RAYON_PARTICULE][j-1];
-            tableau[ID_PARTICULE][j] = tableau[ID_PARTICULE][j-1];
-        }
-        tableau[RAYON_PARTICULE][j] = rayon;
-        tableau[ID_PARTICULE][j] = indice;
-    }
+    actifs_perimes = true;
 }
 
 double calcul_temps(C2D particule, int id_robot)
 {
     double temps=0;
     C2D cercle_robot=tab[id_robot].position;
-    double distance=util_angle(particule.centre, cercle_robot.centre);
+    double distance=util_distance(particule.centre, cercle_robot.centre);
     double angle;
     util_ecart_angle(cercle_robot.centre, tab[id_robot].angle, particule.centre, 
 					 &angle);
@@ -217,131 +432,109 @@ double calcul_temps(C2D particule, int id_robot)
 }
 
 
+// le robot libre le plus rapide à rejoindre la particule est cherché dans l'arbre
+// construit par attribution_but; à temps égal, le plus grand indice l'emporte
 void robot_proche(int part)
 {
     C2D coord_particule = particule_position(part);
-    int robot_min=0;
-    double temps;
-    double temps_max;
-    for (int j=0; j<nb; j++)
-    {
-		if (tab[j].occupe==false)
-		{
-			temps_max=calcul_temps(coord_particule, 0);
-			robot_min=j;
-			break;
-		}
-	}
-    for (int i=0; i<nb; i++)
-    {
-        temps=calcul_temps(coord_particule, i);
-        if(tab[i].occupe==false)
-        {
-            if (temps<=temps_max)
-            {
-                robot_min=i;
-                temps_max=temps;
-            }
-        }
-    }
+    int robot_min=-1;
+    double temps_min=INFINITY;
+    arbre_chercher(0, nb, 0, coord_particule, &temps_min, &robot_min);
+    if (robot_min < 0)
+		return;
     tab[robot_min].occupe=true;
     tab[robot_min].particule_cible=part;
+    actifs_perimes = true;
+    arbre_retirer(robot_min);
 }
 
+// les plus grosses particules sont visées en premier; avec moins de particules
+// que de robots, les robots restants sont répartis à nouveau sur les particules,
+// de la plus grosse à la plus petite. Les cibles et l'arbre vivent dans l'arène
+// du tour.
 void attribution_but(void)
 {
-    int nb_part= particule_nb_particules();
-    double rayon_part[NB_COORD][nb_part];
-    C2D coord;
-    int part;
-    for (int i=0; i<nb_part; i++)
-    {
-        coord=particule_position(i+1);
-        rayon_part[ID_PARTICULE][i]=i+1;
-        rayon_part[RAYON_PARTICULE][i]=coord.rayon;
-    }
-    tri_particule(nb_part, rayon_part);
+    int nb_part = particule_nb_particules();
+    int k, nb_cibles = nb_part < nb ? nb_part : nb;
+    int *cibles = arene_allouer(nb_cibles*sizeof(int));
+    nb_cibles = particule_plus_grosses(nb_cibles, cibles);
+    for (int i=0; i<nb; i++)
+		robot_synchroniser(i);
     set_robot_occupe();
-    if (nb_part>=nb)
+    arbre_construire();
+    for (k=0; nb_cibles && k<nb; k++)
+        robot_proche(cibles[k % nb_cibles]);
+    if (NAVIGATION_ACTIVE)
+		robot_construire_champs();
+    if (evenementiel)
+		robot_replanifier(-1);
+}
+
+// le déplacement du robot i de sa position actuelle jusqu'à robot est balayé contre
+// les corps voisins; le robot s'arrête au premier contact rencontré, ce qui
+// évite l'effet tunnel même avec un grand DELTA_T. Le contact est résolu
+// exactement: aucun chevauchement ne devrait rester, ce qui est contrôlé
+void robot_collision_correction(int i, C2D robot)
+{
+    int j, k, obstacle = -1;
+    double t, dist, t_impact = 1.;
+    C2D depart = tab[i].position;
+    S2D depl = {robot.centre.x - depart.centre.x, robot.centre.y - depart.centre.y};
+    // un robot heurté touche le cercle qui englobe tout le déplacement; la marge
+    // EPSIL_ZERO couvre les arrondis. Les robots de la grille proches de ce
+    // cercle sont testés par lots
+    C2D zone = {{depart.centre.x + depl.x/2., depart.centre.y + depl.y/2.},
+                depart.rayon + sqrt(depl.x*depl.x + depl.y*depl.y)/2. + EPSIL_ZERO};
+    robot_chercher_contacts(i, zone);
+    nb_candidats += contacts.nb;
+    for (j=0; j < contacts.nb &&
+			  (k = util_collision_lot(zone, &contacts.x[j], &contacts.y[j],
+									  &contacts.r[j], contacts.nb-j)) >= 0; j+=k+1)
     {
-        for (int j=1; j<=nb; j++)
+        // à instant égal, le plus petit indice l'emporte: le résultat ne dépend
+        // pas de l'ordre des robots dans la grille
+        if (util_impact_cercle(depart, depl, tab[contacts.robots[j+k]].position,
+							   &t) && (t < t_impact || (t == t_impact &&
+							   obstacle >= 0 && contacts.robots[j+k] < obstacle)))
         {
-            part=rayon_part[ID_PARTICULE][nb_part-j];
-            robot_proche(part);
+			t_impact = t;
+			obstacle = contacts.robots[j+k];
         }
     }
-    if (nb_part<nb)
+    // seules les particules des chunks traversés par le déplacement sont testées
+    BALAYAGE balayage = {depart, depl, t_impact, 0};
+    S2D coin_min, coin_max;
+    robot_zone_balayage(&balayage, &coin_min, &coin_max);
+    particule_parcourir_zone(coin_min, coin_max, robot_balayer_particule, &balayage);
+    particule_heurtee = balayage.particule;
+    if (balayage.particule)
     {
-        int k;
-        for (k=1; k<=nb_part; k++)
-        {
-            part=rayon_part[ID_PARTICULE][nb_part-k];
-            robot_proche(part);
-        }
-        for (k=1; k<=nb-nb_part; k++)
-        {
-            part=rayon_part[ID_PARTICULE][nb_part-k];
-            robot_proche(part);
-        }
+        t_impact = balayage.t_impact;
+        tab[i].arret = ARRET_PARTICULE;
+        if (!tab[i].bloque)
+			tab[i].particule_cible = balayage.particule;
     }
-}
-
-bool robot_collision_rob_cercle(C2D a, C2D b)
-{
-    double dist;
-    return util_collision_cercle(a, b, &dist);
-}
-
-C2D recul_robot(C2D pos_actuelle, int i, C2D cible)
-{
-    double delta_d = util_distance(tab[i].position.centre, pos_actuelle.centre);
-    double D = util_distance(pos_actuelle.centre, cible.centre);
-    double L = util_distance(tab[i].position.centre, cible.centre);
-    double rayons = pos_actuelle.rayon + cible.rayon;
-    double new_dist;
-    util_inner_triangle(delta_d, D, L, rayons, &new_dist);
-	if (fabs(new_dist) > fabs(tab[i].vtrans * DELTA_T))
-		new_dist=0;
-    if (tab[i].vtrans >0)
+    else if (obstacle >= 0)
     {
-        pos_actuelle.centre.x = tab[i].position.centre.x + new_dist*cos(tab[i].angle);
-        pos_actuelle.centre.y = tab[i].position.centre.y + new_dist*sin(tab[i].angle);
+		tab[i].arret = ARRET_ROBOT;
+		tab[i].normale = util_angle(depart.centre, tab[obstacle].position.centre);
     }
     else
+		tab[i].arret = ARRET_AUCUN;
+    // un déplacement complet garde exactement la position proposée
+    if (t_impact < 1.)
     {
-        pos_actuelle.centre.x = tab[i].position.centre.x - new_dist*cos(tab[i].angle);
-        pos_actuelle.centre.y = tab[i].position.centre.y -new_dist*sin(tab[i].angle);
-    }
-    return pos_actuelle;
-}
-
-void robot_collision_correction(int i, C2D robot)
-{
-    int j;
-    C2D robot_cible;
-    for (j=0; j < nb; j++)
-    {
-        if (j != i)
-        {
-			robot_cible=tab[j].position;
-            if (robot_collision_rob_cercle(robot, robot_cible))
-            {
-                robot = recul_robot(robot, i, tab[j].position);
-            }
-        }
+		robot.centre.x = depart.centre.x + t_impact*depl.x;
+		robot.centre.y = depart.centre.y + t_impact*depl.y;
+		nb_arrets++;
     }
-    int nb_part = particule_nb_particules();
-    C2D particule;
-    for (j=1; j<=nb_part; j++)
+    tab[i].position=robot;
+    for (k=0; k<contacts.nb; k++)
     {
-        particule = particule_position(j);
-        if (robot_collision_rob_cercle(robot, particule))
-        {
-            robot = recul_robot(robot, i, particule);
-            tab[i].particule_cible=j;
-        }
+		if (util_collision_cercle(robot, tab[contacts.robots[k]].position, &dist))
+			nb_chevauchements++;
     }
-    tab[i].position=robot;
+    robot_indexer(i);
 }
 
 void deplacement_robot_normal(int i)
@@ -351,46 +544,52 @@ void deplacement_robot_normal(int i)
     int id_part=tab[i].particule_cible;
     C2D particule=particule_position(id_part);
     C2D cercle_robot=tab[i].position;
-    double angle;
+    double angle, rotation;
+    S2D nul = {0., 0.};
+    bool aligne = false;
+    robot_suivre_progres(i, particule.centre);
+    if (tab[i].bloque && tab[i].cote)
+		particule.centre = robot_contournement(i);
+    else if (NAVIGATION_ACTIVE)
+		navigation_but(id_part, particule, cercle_robot.centre, &particule.centre);
     util_ecart_angle(cercle_robot.centre, tab[i].angle, particule.centre, &angle);
     util_range_angle(&angle);
+    rotation = angle > 0 ? tab[i].vrot*DELTA_T : -tab[i].vrot*DELTA_T;
     if (fabs(angle)> M_PI*0.5)
     {
-        if (angle>0)
-        {
-            tab[i].angle+=tab[i].vrot*DELTA_T;
-        }
-        else
+        // rotation sur place, poursuivie comme un trajet
+        if (!robot_sur_trajet(i) || tab[i].rotation != (REEL)rotation)
+			robot_commencer_trajet(i, tab[i].angle, rotation, nul, particule.centre);
+        robot_etat_trajet(i, ++tab[i].parcours, &cercle_robot.centre,
+						  &tab[i].angle);
+    }
+    else if (fabs(angle)<= fabs(tab[i].vrot*DELTA_T))
+    {
+        // aligné: ligne droite vers le but, poursuivie comme un trajet tant que
+        // le but ne change pas
+        if (!robot_sur_trajet(i) || tab[i].rotation != 0. ||
+			tab[i].but.x != particule.centre.x || tab[i].but.y != particule.centre.y)
         {
-            tab[i].angle-=tab[i].vrot*DELTA_T;
+            double cap = util_angle(cercle_robot.centre, particule.centre);
+            util_range_angle(&cap);
+            robot_commencer_trajet(i, cap, 0.,
+								   util_deplacement(nul, cap, tab[i].vtrans*DELTA_T),
+								   particule.centre);
         }
+        robot_etat_trajet(i, ++tab[i].parcours, &cercle_robot.centre,
+						  &tab[i].angle);
+        aligne = true;
     }
     else
     {
-        if (fabs(angle)<= fabs(tab[i].vrot*DELTA_T))
-        {
-            double temp =util_angle(cercle_robot.centre, particule.centre);
-            util_range_angle(&temp);
-            tab[i].angle=temp;
-        }
-        else
-        {
-            if (angle>0)
-            {
-                tab[i].angle+=tab[i].vrot*DELTA_T;
-            }
-            else
-            {
-                tab[i].angle-=tab[i].vrot*DELTA_T;
-            }
-        }
-        double distance = tab[i].vtrans*DELTA_T;
-        cercle_robot.centre.x+=distance*cos(tab[i].angle);
-        cercle_robot.centre.y+=distance*sin(tab[i].angle);
-        
-        
+        robot_quitter_trajet(i);
+        tab[i].angle += rotation;
+        cercle_robot.centre = util_deplacement(cercle_robot.centre, tab[i].angle,
+											   tab[i].vtrans*DELTA_T);
     }
     robot_collision_correction(i, cercle_robot);
+    if (aligne && tab[i].arret != ARRET_AUCUN)
+		robot_signaler_arret(i);
 }
 
 void decontamination(int id)
@@ -404,6 +603,8 @@ void decontamination(int id)
         cercle_robot.rayon + EPSIL_ZERO) &&
         (fabs(temp_angle-tab[id].angle)<EPSIL_ALIGNEMENT))
     {
+        if (tab[id].bloque)
+			nb_recuperes++;
         eliminer_particule(id_part);
     }
 }
@@ -412,9 +613,8 @@ void deplacement_robot_manual(int i)
 {
 	C2D cercle_robot=tab[i].position;
 	tab[i].angle += tab[i].vrot*DELTA_T;
-	double distance = tab[i].vtrans*DELTA_T;
-    cercle_robot.centre.x+=distance*cos(tab[i].angle);
-    cercle_robot.centre.y+=distance*sin(tab[i].angle);
+	cercle_robot.centre = util_deplacement(cercle_robot.centre, tab[i].angle,
+										   tab[i].vtrans*DELTA_T);
 	robot_collision_correction(i, cercle_robot);
 }
 
@@ -445,16 +645,68 @@ void soustraire_vitesse_translation(int i)
 
 void selectionner_robot(int id)
 {
+	if (!tab[id].manual)
+	{
+		if (nb_manuels == capacite_manuels)
+		{
+			capacite_manuels = capacite_manuels ? 2*capacite_manuels : 4;
+			if (!(manuels = realloc(manuels, capacite_manuels*sizeof(int))))
+				exit(EXIT_FAILURE);
+		}
+		tab[id].place_manuel = nb_manuels;
+		manuels[nb_manuels++] = id;
+	}
 	tab[id].manual=true;
 	tab[id].vrot=0;
 	tab[id].vtrans=0;
+	robot_oublier_progres(id);
+	actifs_perimes = true;
+	if (evenementiel)
+		robot_planifier(id, tick);
 }
 
 void deselectionner_robot(int id)
 {
+	bool etait_manuel = tab[id].manual;
+	if (etait_manuel)
+	{
+		manuels[tab[id].place_manuel] = manuels[--nb_manuels];
+		tab[manuels[tab[id].place_manuel]].place_manuel = tab[id].place_manuel;
+		tab[id].place_manuel = -1;
+	}
 	tab[id].manual=false;
 	tab[id].vrot=VROT_MAX;
 	tab[id].vtrans=VTRAN_MAX;
+	robot_oublier_progres(id);
+	actifs_perimes = true;
+	if (evenementiel && etait_manuel)
+		robot_planifier(id, tick);
+}
+
+void robot_deselectionner_tout(void)
+{
+	while (nb_manuels)
+		deselectionner_robot(manuels[nb_manuels-1]);
+}
+
+int robot_nb_manuels(void)
+{
+	return nb_manuels;
+}
+
+int robot_manuel(int k)
+{
+	assert(0 <= k && k < nb_manuels);
+	return manuels[k];
+}
+
+// le plus petit indice parmi les robots contenant le point, comme un parcours
+// de tous les robots dans l'ordre
+int robot_choisir(S2D point)
+{
+	CHOIX choix = {point, -1};
+	grille_parcourir(point, robot_choisir_candidat, &choix);
+	return choix.robot;
 }
 
 double retourner_vtran(int id)
@@ -471,4 +723,875 @@ void eliminer_tout_robot(void)
 {
 	free(tab);
 	tab=NULL;
+	navigation_vider();
+	free(tas);
+	tas=NULL;
+	taille_tas=0;
+	capacite_tas=0;
+	arbre = (ARBRE){NULL, NULL, NULL, NULL, NULL};
+	free(contacts.robots);
+	free(contacts.x);
+	free(contacts.y);
+	free(contacts.r);
+	contacts = (CONTACTS){-1, 0, 0, NULL, NULL, NULL, NULL};
+	free(manuels);
+	manuels=NULL;
+	nb_manuels=0;
+	capacite_manuels=0;
+	free(actifs);
+	actifs=NULL;
+	nb_actifs=0;
+	actifs_perimes=true;
+	grille_vider();
+}
+
+void robot_set_evenementiel(bool actif)
+{
+	int i;
+	for (i=0; i<nb; i++)
+	{
+		robot_synchroniser(i);
+		robot_arreter(i);
+		tab[i].echeance = AUCUNE_ECHEANCE;
+	}
+	evenementiel = actif;
+	taille_tas = 0;
+	if (actif)
+	{
+		for (i=0; i<nb; i++)
+			robot_planifier(i, tick);
+	}
+}
+
+bool robot_evenementiel(void)
+{
+	return evenementiel;
+}
+
+void robot_statistiques_blocages(unsigned long *p_blocages,
+								 unsigned long *p_recuperes)
+{
+	*p_blocages = nb_blocages;
+	*p_recuperes = nb_recuperes;
+}
+
+void robot_statistiques_contacts(unsigned long *p_candidats,
+								 unsigned long *p_arrets,
+								 unsigned long *p_chevauchements)
+{
+	*p_candidats = nb_candidats;
+	*p_arrets = nb_arrets;
+	*p_chevauchements = nb_chevauchements;
+}
+
+// même ordre de traitement qu'une boucle sur tous les robots, les robots
+// inactifs n'y faisant rien
+void robot_deplacement_standard(void)
+{
+	int k;
+	robot_rafraichir_actifs();
+	for (k=0; k<nb_actifs; k++)
+	{
+		robot_deplacer_isole(actifs[k]);
+		robot_decontaminer(actifs[k]);
+	}
+}
+
+int robot_actifs(const int **p_actifs)
+{
+	robot_rafraichir_actifs();
+	*p_actifs = actifs;
+	return nb_actifs;
+}
+
+// traite uniquement les robots dont l'évènement est échu; les robots en vol libre
+// ne sont pas touchés et leur position n'est calculée que lorsqu'elle est lue
+void robot_deplacement_evenementiel(void)
+{
+	EVENEMENT e;
+	int i;
+	// comme dans la boucle standard, un changement de la liste de particules
+	// modifie immédiatement la particule désignée par l'indice cible
+	if (particule_nb_particules() != nb_part_connu)
+		robot_replanifier(-1);
+	while (taille_tas > 0 && tas[0].echeance <= tick)
+	{
+		e = tas_extraire();
+		i = e.robot;
+		// évènement périmé: le robot a été replanifié entre temps
+		if (e.echeance != tab[i].echeance)
+			continue;
+		robot_synchroniser(i);
+		robot_arreter(i);
+		tab[i].echeance = AUCUNE_ECHEANCE;
+		if (tab[i].manual)
+			deplacement_robot_manual(i);
+		else
+		{
+			deplacement_robot_normal(i);
+			decontamination(i);
+		}
+		robot_prevoir(i);
+		if (particule_nb_particules() != nb_part_connu)
+			robot_replanifier(i);
+	}
+	tick++;
+}
+
+// la cible est lue avant le déplacement, qui peut la remplacer par la particule
+// heurtée
+int robot_deplacer_isole(int i)
+{
+	int lue = tab[i].particule_cible;
+	particule_heurtee = 0;
+	if (tab[i].manual)
+		deplacement_robot_manual(i);
+	else
+		deplacement_robot_normal(i);
+	return particule_heurtee > lue ? particule_heurtee : lue;
+}
+
+// un robot manuel ne décontamine pas: une cible touchée lui reste
+int robot_decontaminer(int i)
+{
+	int cible = tab[i].particule_cible, nb_part = particule_nb_particules();
+	if (!tab[i].manual)
+		decontamination(i);
+	return particule_nb_particules() < nb_part ? cible : 0;
+}
+
+// les champs du mode évènementiel ne sont pas échangés: la répartition
+// fonctionne en mode standard
+void robot_exporter_etat(int i, ETAT_ROBOT *etat)
+{
+	etat->position = tab[i].position.centre;
+	etat->angle = tab[i].angle;
+	etat->vrot = tab[i].vrot;
+	etat->vtrans = tab[i].vtrans;
+	etat->particule_cible = tab[i].particule_cible;
+	etat->occupe = tab[i].occupe;
+	etat->manual = tab[i].manual;
+	etat->distance_min = tab[i].distance_min;
+	etat->arrets = tab[i].arrets;
+	etat->arret = tab[i].arret;
+	etat->normale = tab[i].normale;
+	etat->bloque = tab[i].bloque;
+	etat->cote = tab[i].cote;
+	etat->distance_blocage = tab[i].distance_blocage;
+	etat->ancre = tab[i].ancre;
+	etat->angle_ancre = tab[i].angle_ancre;
+	etat->rotation = tab[i].rotation;
+	etat->pas = tab[i].pas;
+	etat->but = tab[i].but;
+	etat->parcours = tab[i].parcours;
+}
+
+void robot_importer_etat(int i, const ETAT_ROBOT *etat)
+{
+	tab[i].position.centre = etat->position;
+	tab[i].angle = etat->angle;
+	tab[i].vrot = etat->vrot;
+	tab[i].vtrans = etat->vtrans;
+	tab[i].particule_cible = etat->particule_cible;
+	tab[i].occupe = etat->occupe;
+	tab[i].manual = etat->manual;
+	tab[i].distance_min = etat->distance_min;
+	tab[i].arrets = etat->arrets;
+	tab[i].arret = etat->arret;
+	tab[i].normale = etat->normale;
+	tab[i].bloque = etat->bloque;
+	tab[i].cote = etat->cote;
+	tab[i].distance_blocage = etat->distance_blocage;
+	tab[i].ancre = etat->ancre;
+	tab[i].angle_ancre = etat->angle_ancre;
+	tab[i].rotation = etat->rotation;
+	tab[i].pas = etat->pas;
+	tab[i].but = etat->but;
+	tab[i].parcours = etat->parcours;
+	robot_indexer(i);
+}
+
+void robot_exporter_cibles(int *cibles)
+{
+	for (int i=0; i<nb; i++)
+		cibles[i] = tab[i].particule_cible;
+}
+
+// même état que set_robot_occupe suivi de robot_proche pour chaque cible: seuls
+// les robots laissés à -1 sont libres
+void robot_affecter_cibles(const int *cibles)
+{
+	for (int i=0; i<nb; i++)
+	{
+		tab[i].occupe = cibles[i] != -1;
+		tab[i].particule_cible = cibles[i];
+		robot_oublier_progres(i);
+	}
+	actifs_perimes = true;
+	if (NAVIGATION_ACTIVE)
+		robot_construire_champs();
+}
+
+static void robot_planifier(int i, int echeance)
+{
+	EVENEMENT e = {echeance, i};
+	tab[i].echeance = echeance;
+	tas_inserer(e);
+	robot_indexer(i);
+}
+
+// prédit le prochain évènement du robot i qui vient d'être traité. Un robot 
+// automatique aligné sur sa cible passe en vol libre en ligne droite jusqu'au 
+// premier contact possible: contact le long de sa trajectoire avec une particule
+// (dont sa cible), ou rapprochement d'un robot, dont la distance diminue au plus
+// des deux pas maximaux à chaque tour
+static void robot_prevoir(int i)
+{
+	int j, nb_part = particule_nb_particules();
+	double ecart, ecart_max = tab[i].vrot*DELTA_T, pas = tab[i].vtrans*DELTA_T;
+	double jeu, distance, tours_libres;
+	double tours_zone = VOL_LIBRE_MIN/2., tours_balayes = 0., debut;
+	double portee = pas + VTRAN_MAX*DELTA_T;
+	C2D cible, autre, zone, depart = tab[i].position;
+	S2D depl = {0., 0.}, coin_min, coin_max;
+
+	if (!tab[i].manual && !tab[i].occupe)
+		return;
+	if (tab[i].manual || tab[i].bloque || pas <= 0. ||
+		tab[i].particule_cible < 1 || tab[i].particule_cible > nb_part)
+	{
+		robot_planifier(i, tick+1);
+		return;
+	}
+	cible = particule_position(tab[i].particule_cible);
+	tab[i].cible = cible;
+	// le point visé par un robot guidé change avec sa case
+	if (NAVIGATION_ACTIVE && navigation_couvre(tab[i].particule_cible, cible))
+	{
+		robot_planifier(i, tick+1);
+		return;
+	}
+	if (!util_ecart_angle(depart.centre, tab[i].angle, cible.centre, &ecart))
+	{
+		robot_planifier(i, tick+1);
+		return;
+	}
+	if (fabs(ecart) > M_PI*0.5)
+	{
+		// rotation sur place tant que l'écart dépasse pi/2, comme dans 
+		// deplacement_robot_normal; évènement au dernier tour de cette rotation,
+		// traité normalement car l'écart calculé à ce tour peut différer d'un
+		// arrondi de l'estimation
+		tours_libres = ceil((fabs(ecart) - M_PI*0.5)/ecart_max) - 1.;
+		if (tours_libres < VOL_LIBRE_MIN || !robot_sur_trajet(i) ||
+			tab[i].rotation == 0.)
+		{
+			robot_planifier(i, tick+1);
+			return;
+		}
+		robot_envoler(i);
+		robot_planifier(i, tick+1+(int)tours_libres);
+		return;
+	}
+	// rotation avec translation: traitée à chaque tour jusqu'à l'alignement. Le
+	// vol libre poursuit la ligne droite que deplacement_robot_normal vient de 
+	// commencer ou de prolonger vers le centre de la cible
+	if (fabs(ecart) > ecart_max || !robot_sur_trajet(i) || tab[i].rotation != 0. ||
+		tab[i].but.x != cible.centre.x || tab[i].but.y != cible.centre.y)
+	{
+		robot_planifier(i, tick+1);
+		return;
+	}
+	distance = util_distance(depart.centre, cible.centre);
+	// la décontamination est possible dès que la cible est à EPSIL_ZERO du contact
+	tours_libres = (distance - depart.rayon - cible.rayon - EPSIL_ZERO)/pas;
+	// les robots de la grille sont cherchés dans une zone doublée à chaque
+	// passage, jusqu'à contenir tous ceux qui peuvent approcher pendant le vol
+	// trouvé; le rectangle d'un robot contient sa position courante
+	zone.centre = depart.centre;
+	while (tours_libres > tours_zone && tours_libres >= VOL_LIBRE_MIN)
+	{
+		tours_zone = fmin(2*tours_zone, tours_libres);
+		zone.rayon = depart.rayon + R_ROBOT + EPSIL_ZERO + tours_zone*portee;
+		robot_chercher_contacts(i, zone);
+		for (j=0; j<contacts.nb; j++)
+		{
+			autre.centre.x = contacts.x[j];
+			autre.centre.y = contacts.y[j];
+			jeu = util_distance(depart.centre, autre.centre) - depart.rayon -
+				  contacts.r[j] - EPSIL_ZERO;
+			tours_libres = fmin(tours_libres, jeu/portee);
+		}
+	}
+	// de même, les particules sont balayées par tronçons de longueur doublée à
+	// chaque passage, jusqu'au premier contact ou à la fin du vol
+	BALAYAGE balayage = {depart, depl, 1., 0};
+	while (!balayage.particule && tours_libres > tours_balayes &&
+		   tours_libres >= VOL_LIBRE_MIN)
+	{
+		debut = tours_balayes;
+		tours_balayes = fmin(fmax(2*tours_balayes, VOL_LIBRE_MIN), tours_libres);
+		balayage.depart.centre = util_deplacement(depart.centre,
+												  tab[i].angle_ancre, debut*pas);
+		balayage.depl = util_deplacement(depl, tab[i].angle_ancre,
+										 (tours_balayes - debut)*pas);
+		robot_zone_balayage(&balayage, &coin_min, &coin_max);
+		particule_parcourir_zone(coin_min, coin_max, robot_balayer_particule,
+								 &balayage);
+		if (balayage.particule)
+			tours_libres = fmin(tours_libres, debut + balayage.t_impact*
+											  (tours_balayes - debut));
+	}
+	if (tours_libres < VOL_LIBRE_MIN)
+	{
+		robot_planifier(i, tick+1);
+		return;
+	}
+	robot_envoler(i);
+	// nombre de tours de vol strictement avant le premier contact possible
+	robot_planifier(i, tick+(int)ceil(tours_libres));
+}
+
+// après un changement des particules ou des buts, le vol libre n'est conservé que
+// si la cible du robot est restée la même particule. Les robots d'indice <= dernier
+// ont déjà effectué leur déplacement du tour courant: ils terminent ce tour en vol
+// libre et sont traités au tour suivant
+static void robot_replanifier(int dernier)
+{
+	int i;
+	C2D cible;
+	nb_part_connu = particule_nb_particules();
+	for (i=0; i<nb; i++)
+	{
+		if (tab[i].manual || i == dernier)
+			continue;
+		if (robot_vol_libre(i))
+		{
+			cible = particule_position(tab[i].particule_cible);
+			if (tab[i].occupe && cible.centre.x == tab[i].cible.centre.x &&
+				cible.centre.y == tab[i].cible.centre.y &&
+				cible.rayon == tab[i].cible.rayon &&
+				!(NAVIGATION_ACTIVE &&
+				  navigation_couvre(tab[i].particule_cible, cible)))
+				continue;
+			if (i < dernier)
+			{
+				robot_planifier(i, tick+1);
+				continue;
+			}
+			robot_synchroniser(i);
+			robot_arreter(i);
+			robot_planifier(i, tick);
+		}
+		else if (tab[i].occupe && tab[i].echeance == AUCUNE_ECHEANCE)
+			robot_planifier(i, i < dernier ? tick+1 : tick);
+	}
+}
+
+// enregistre la position et l'orientation courantes d'un robot en vol libre,
+// recalculées depuis l'ancre de son trajet: des lectures répétées n'accumulent
+// pas d'arrondis et le robot arrive exactement à l'état de la boucle standard
+static void robot_synchroniser(int i)
+{
+	if (!robot_vol_libre(i) || tick - tab[i].tick_base <= tab[i].parcours)
+		return;
+	tab[i].parcours = tick - tab[i].tick_base;
+	robot_etat_trajet(i, tab[i].parcours, &tab[i].position.centre, &tab[i].angle);
+}
+
+// le robot qui vient de faire un pas de son trajet le poursuit en vol libre
+static void robot_envoler(int i)
+{
+	tab[i].vol = true;
+	tab[i].tick_base = tick+1 - tab[i].parcours;
+}
+
+// termine le vol libre d'un robot, qui doit avoir été synchronisé; il reste sur
+// son trajet
+static void robot_arreter(int i)
+{
+	tab[i].vol = false;
+}
+
+static void robot_etat_trajet(int i, int parcours, S2D *p_centre, REEL *p_angle)
+{
+	p_centre->x = tab[i].ancre.x + parcours*tab[i].pas.x;
+	p_centre->y = tab[i].ancre.y + parcours*tab[i].pas.y;
+	*p_angle = tab[i].angle_ancre + parcours*tab[i].rotation;
+}
+
+// vrai si le robot est dans l'état de son trajet: son dernier pas n'a été ni
+// tronqué par un contact ni remplacé par un autre déplacement
+static bool robot_sur_trajet(int i)
+{
+	S2D centre;
+	REEL angle;
+	if (tab[i].rotation == 0. && tab[i].pas.x == 0. && tab[i].pas.y == 0.)
+		return false;
+	robot_etat_trajet(i, tab[i].parcours, &centre, &angle);
+	return centre.x == tab[i].position.centre.x &&
+		   centre.y == tab[i].position.centre.y && angle == tab[i].angle;
+}
+
+static void robot_commencer_trajet(int i, double angle, double rotation, S2D pas,
+								   S2D but)
+{
+	tab[i].ancre = tab[i].position.centre;
+	tab[i].angle_ancre = angle;
+	tab[i].rotation = rotation;
+	tab[i].pas = pas;
+	tab[i].but = but;
+	tab[i].parcours = 0;
+}
+
+static void robot_quitter_trajet(int i)
+{
+	tab[i].rotation = 0.;
+	tab[i].pas.x = 0.;
+	tab[i].pas.y = 0.;
+	tab[i].parcours = 0;
+}
+
+// position courante du robot i, y compris en vol libre
+static C2D robot_cercle(int i)
+{
+	robot_synchroniser(i);
+	return tab[i].position;
+}
+
+// rectangle englobant le cercle sur tout son déplacement
+static void robot_zone_balayage(BALAYAGE *balayage, S2D *p_min, S2D *p_max)
+{
+	C2D depart = balayage->depart;
+	S2D arrivee = {depart.centre.x + balayage->depl.x, 
+				   depart.centre.y + balayage->depl.y};
+	p_min->x = fmin(depart.centre.x, arrivee.x) - depart.rayon;
+	p_min->y = fmin(depart.centre.y, arrivee.y) - depart.rayon;
+	p_max->x = fmax(depart.centre.x, arrivee.x) + depart.rayon;
+	p_max->y = fmax(depart.centre.y, arrivee.y) + depart.rayon;
+}
+
+// garde le premier contact; à instant égal, la particule de plus petit indice
+// l'emporte, comme avec un parcours des particules dans l'ordre des indices
+static void robot_balayer_particule(int indice, C2D cercle, void *donnees)
+{
+	BALAYAGE *balayage = donnees;
+	double t;
+	if (util_impact_cercle(balayage->depart, balayage->depl, cercle, &t) &&
+		(t < balayage->t_impact || (t == balayage->t_impact && 
+		 balayage->particule && indice < balayage->particule)))
+	{
+		balayage->t_impact = t;
+		balayage->particule = indice;
+	}
+}
+
+static bool robot_vol_libre(int i)
+{
+	return tab[i].vol;
+}
+
+// ordre de la file: échéance puis indice, pour garder l'ordre de mise à jour
+// séquentiel des robots traités au même tour
+static bool tas_avant(EVENEMENT a, EVENEMENT b)
+{
+	return a.echeance < b.echeance ||
+		   (a.echeance == b.echeance && a.robot < b.robot);
+}
+
+static void tas_inserer(EVENEMENT e)
+{
+	int i = taille_tas++, parent;
+	if (taille_tas > capacite_tas)
+	{
+		capacite_tas = capacite_tas ? 2*capacite_tas : nb + 1;
+		if (!(tas = realloc(tas, capacite_tas*sizeof(EVENEMENT))))
+			exit(EXIT_FAILURE);
+	}
+	while (i > 0 && tas_avant(e, tas[parent = (i-1)/2]))
+	{
+		tas[i] = tas[parent];
+		i = parent;
+	}
+	tas[i] = e;
+}
+
+static EVENEMENT tas_extraire(void)
+{
+	EVENEMENT premier = tas[0], dernier = tas[--taille_tas];
+	int i = 0, fils;
+	while ((fils = 2*i+1) < taille_tas)
+	{
+		if (fils+1 < taille_tas && tas_avant(tas[fils+1], tas[fils]))
+			fils++;
+		if (!tas_avant(tas[fils], dernier))
+			break;
+		tas[i] = tas[fils];
+		i = fils;
+	}
+	tas[i] = dernier;
+	return premier;
+}
+
+static double robot_coord(int i, int axe)
+{
+	return axe ? tab[i].position.centre.y : tab[i].position.centre.x;
+}
+
+// tous les robots sont libres à la construction; médianes et boîtes en
+// O(nb log nb). Les tableaux sont pris dans l'arène: l'arbre ne sert que pendant
+// l'attribution qui le construit.
+static void arbre_construire(void)
+{
+	int k;
+	arbre.ordre = arene_allouer(nb*sizeof(int));
+	arbre.place = arene_allouer(nb*sizeof(int));
+	arbre.libres = arene_allouer(nb*sizeof(int));
+	arbre.coin_min = arene_allouer(nb*sizeof(S2D));
+	arbre.coin_max = arene_allouer(nb*sizeof(S2D));
+	for (k = 0; k < nb; k++)
+		arbre.ordre[k] = k;
+	arbre_construire_noeud(0, nb, 0);
+	for (k = 0; k < nb; k++)
+		arbre.place[arbre.ordre[k]] = k;
+}
+
+static void arbre_construire_noeud(int debut, int fin, int axe)
+{
+	int k, milieu = (debut+fin)/2;
+	S2D centre;
+	if (debut >= fin)
+		return;
+	arbre_selectionner(debut, fin, milieu, axe);
+	arbre.libres[milieu] = fin - debut;
+	arbre.coin_min[milieu] = arbre.coin_max[milieu] =
+		tab[arbre.ordre[debut]].position.centre;
+	for (k = debut+1; k < fin; k++)
+	{
+		centre = tab[arbre.ordre[k]].position.centre;
+		arbre.coin_min[milieu].x = fmin(arbre.coin_min[milieu].x, centre.x);
+		arbre.coin_min[milieu].y = fmin(arbre.coin_min[milieu].y, centre.y);
+		arbre.coin_max[milieu].x = fmax(arbre.coin_max[milieu].x, centre.x);
+		arbre.coin_max[milieu].y = fmax(arbre.coin_max[milieu].y, centre.y);
+	}
+	arbre_construire_noeud(debut, milieu, !axe);
+	arbre_construire_noeud(milieu+1, fin, !axe);
+}
+
+// sélection rapide: place en k le robot de rang k selon l'axe, les plus petits
+// avant et les plus grands après
+static void arbre_selectionner(int debut, int fin, int k, int axe)
+{
+	int i, j, echange;
+	double pivot;
+	fin--;
+	while (debut < fin)
+	{
+		pivot = robot_coord(arbre.ordre[(debut+fin)/2], axe);
+		i = debut;
+		j = fin;
+		while (i <= j)
+		{
+			while (robot_coord(arbre.ordre[i], axe) < pivot)
+				i++;
+			while (robot_coord(arbre.ordre[j], axe) > pivot)
+				j--;
+			if (i <= j)
+			{
+				echange = arbre.ordre[i];
+				arbre.ordre[i++] = arbre.ordre[j];
+				arbre.ordre[j--] = echange;
+			}
+		}
+		if (k <= j)
+			fin = j;
+		else if (k >= i)
+			debut = i;
+		else
+			return;
+	}
+}
+
+// le robot devenu occupé reste dans l'arbre mais n'est plus compté: les
+// sous-arbres sans robot libre sont ignorés par la recherche
+static void arbre_retirer(int robot)
+{
+	int debut = 0, fin = nb, milieu, place = arbre.place[robot];
+	while (debut < fin)
+	{
+		milieu = (debut+fin)/2;
+		arbre.libres[milieu]--;
+		if (place == milieu)
+			return;
+		if (place < milieu)
+			fin = milieu;
+		else
+			debut = milieu+1;
+	}
+}
+
+// la distance à la boîte d'un sous-arbre divisée par VTRAN_MAX minore le temps de
+// tous ses robots, l'écart d'orientation pouvant être nul
+static void arbre_chercher(int debut, int fin, int axe, C2D particule,
+						   double *p_temps_min, int *p_robot_min)
+{
+	int milieu = (debut+fin)/2, robot;
+	double dx, dy, temps;
+	if (debut >= fin || !arbre.libres[milieu])
+		return;
+	dx = fmax(0., fmax(arbre.coin_min[milieu].x - particule.centre.x,
+					   particule.centre.x - arbre.coin_max[milieu].x));
+	dy = fmax(0., fmax(arbre.coin_min[milieu].y - particule.centre.y,
+					   particule.centre.y - arbre.coin_max[milieu].y));
+	if (sqrt(dx*dx + dy*dy)/VTRAN_MAX > *p_temps_min)
+		return;
+	robot = arbre.ordre[milieu];
+	if (!tab[robot].occupe)
+	{
+		temps = calcul_temps(particule, robot);
+		if (temps < *p_temps_min || (temps == *p_temps_min && robot > *p_robot_min))
+		{
+			*p_temps_min = temps;
+			*p_robot_min = robot;
+		}
+	}
+	// le côté de la particule d'abord, pour resserrer la borne au plus tôt
+	if ((axe ? particule.centre.y : particule.centre.x) < robot_coord(robot, axe))
+	{
+		arbre_chercher(debut, milieu, !axe, particule, p_temps_min, p_robot_min);
+		arbre_chercher(milieu+1, fin, !axe, particule, p_temps_min, p_robot_min);
+	}
+	else
+	{
+		arbre_chercher(milieu+1, fin, !axe, particule, p_temps_min, p_robot_min);
+		arbre_chercher(debut, milieu, !axe, particule, p_temps_min, p_robot_min);
+	}
+}
+static void robot_oublier_progres(int i)
+{
+	tab[i].distance_min = INFINITY;
+	tab[i].arrets = 0;
+	tab[i].arret = ARRET_AUCUN;
+	tab[i].bloque = false;
+	tab[i].cote = 0;
+}
+
+// le robot est suivi avant son déplacement, à chaque tour où il est traité; en
+// vol libre il se rapproche à chaque tour, si bien que le mode évènementiel
+// aboutit au même état que la boucle standard
+static void robot_suivre_progres(int i, S2D cible)
+{
+	double distance = util_distance(tab[i].position.centre, cible);
+	if (distance < tab[i].distance_min - EPSIL_ZERO)
+		tab[i].arrets = 0;
+	tab[i].distance_min = fmin(tab[i].distance_min, distance);
+	if (tab[i].bloque && distance < tab[i].distance_blocage - R_ROBOT)
+	{
+		tab[i].bloque = false;
+		tab[i].cote = 0;
+		nb_recuperes++;
+	}
+}
+
+// après ARRETS_BLOCAGE arrêts sans progrès le robot est bloqué. Arrêté par un
+// robot, il le contourne du côté de sa cible, puis de l'autre côté s'il reste
+// bloqué; arrêté par une particule, il garde sa cible au lieu de passer d'une
+// particule touchée à l'autre
+static void robot_signaler_arret(int i)
+{
+	double ecart;
+	if (++tab[i].arrets < ARRETS_BLOCAGE)
+		return;
+	tab[i].arrets = 0;
+	if (!tab[i].bloque)
+	{
+		tab[i].bloque = true;
+		tab[i].distance_blocage = tab[i].distance_min;
+		nb_blocages++;
+	}
+	if (tab[i].arret == ARRET_PARTICULE)
+		tab[i].cote = 0;
+	else if (tab[i].cote)
+		tab[i].cote = -tab[i].cote;
+	else
+	{
+		ecart = util_angle(tab[i].position.centre,
+						   particule_position(tab[i].particule_cible).centre) -
+				tab[i].normale;
+		util_range_angle(&ecart);
+		tab[i].cote = ecart >= 0. ? 1 : -1;
+	}
+}
+
+// point visé en contournement: tangent au dernier robot qui a arrêté le robot,
+// dont la direction est retenue au moment de l'arrêt
+static S2D robot_contournement(int i)
+{
+	return util_deplacement(tab[i].position.centre,
+							tab[i].normale + tab[i].cote*M_PI*0.5, R_ROBOT);
+}
+
+// range le robot dans la grille d'après tout le trajet de son vol libre jusqu'à
+// son échéance: la synchronisation ne le fait pas sortir de son rectangle
+static void robot_indexer(int i)
+{
+	C2D depart = tab[i].position;
+	S2D arrivee = depart.centre, coin_min, coin_max;
+	REEL angle;
+
+	if (robot_vol_libre(i))
+		robot_etat_trajet(i, tab[i].echeance - tab[i].tick_base, &arrivee, &angle);
+	coin_min.x = fmin(depart.centre.x, arrivee.x) - depart.rayon;
+	coin_min.y = fmin(depart.centre.y, arrivee.y) - depart.rayon;
+	coin_max.x = fmax(depart.centre.x, arrivee.x) + depart.rayon;
+	coin_max.y = fmax(depart.centre.y, arrivee.y) + depart.rayon;
+	grille_placer(i, coin_min, coin_max);
+}
+
+static void robot_choisir_candidat(int id, void *donnees)
+{
+	CHOIX *choix = donnees;
+	if ((choix->robot < 0 || id < choix->robot) &&
+		util_point_dans_cercle(choix->point, robot_cercle(id)))
+		choix->robot = id;
+}
+
+// un robot automatique sans cible reste en place et decontamination n'élimine
+// rien pour lui; une cible touchée pendant un contrôle manuel lui reste
+// jusqu'à la prochaine attribution
+static bool robot_actif(int i)
+{
+	return tab[i].manual || tab[i].occupe || tab[i].particule_cible > 0;
+}
+
+static void robot_rafraichir_actifs(void)
+{
+	if (!actifs_perimes)
+		return;
+	nb_actifs = 0;
+	for (int i=0; i<nb; i++)
+	{
+		if (robot_actif(i))
+			actifs[nb_actifs++] = i;
+	}
+	actifs_perimes = false;
+}
+
+// le rectangle de la grille d'un robot contient son cercle, y compris le long
+// de son vol libre: la recherche sur le rectangle de la zone est complète
+static void robot_chercher_contacts(int exclu, C2D zone)
+{
+	S2D coin_min = {zone.centre.x - zone.rayon, zone.centre.y - zone.rayon};
+	S2D coin_max = {zone.centre.x + zone.rayon, zone.centre.y + zone.rayon};
+	contacts.exclu = exclu;
+	contacts.nb = 0;
+	grille_parcourir_zone(coin_min, coin_max, robot_ajouter_contact, &contacts);
+}
+
+// seuls les candidats sont synchronisés, ce qui ne les déplace pas dans la grille
+static void robot_ajouter_contact(int id, void *donnees)
+{
+	CONTACTS *c = donnees;
+	C2D cercle;
+	if (id == c->exclu)
+		return;
+	if (c->nb == c->capacite)
+	{
+		c->capacite = c->capacite ? 2*c->capacite : CAPACITE_CONTACTS_MIN;
+		if (!(c->robots = realloc(c->robots, c->capacite*sizeof(int))) ||
+			!(c->x = realloc(c->x, c->capacite*sizeof(REEL))) ||
+			!(c->y = realloc(c->y, c->capacite*sizeof(REEL))) ||
+			!(c->r = realloc(c->r, c->capacite*sizeof(REEL))))
+			exit(EXIT_FAILURE);
+	}
+	cercle = robot_cercle(id);
+	c->robots[c->nb] = id;
+	c->x[c->nb] = cercle.centre.x;
+	c->y[c->nb] = cercle.centre.y;
+	c->r[c->nb] = cercle.rayon;
+	c->nb++;
+}
+
+// un champ par particule visée par au moins NAVIGATION_ROBOTS_MIN robots, dont
+// l'un au moins ne la voit pas, sur le rectangle qui englobe la particule et ses
+// robots. Les indices de particules changent avec le nombre de particules, qui
+// relance toujours l'attribution des buts: les champs sont repris ici, et seuls
+// ceux dont la cible, la zone ou les obstacles ont changé sont reconstruits
+static void robot_construire_champs(void)
+{
+	int i, part, nb_part = particule_nb_particules();
+	int *nb_robots = arene_allouer((nb_part+1)*sizeof(int));
+	bool *masquee = arene_allouer((nb_part+1)*sizeof(bool));
+	S2D *coin_min = arene_allouer((nb_part+1)*sizeof(S2D));
+	S2D *coin_max = arene_allouer((nb_part+1)*sizeof(S2D));
+	C2D cercle;
+
+	navigation_commencer();
+	for (part = 0; part <= nb_part; part++)
+	{
+		nb_robots[part] = 0;
+		masquee[part] = false;
+	}
+	for (i = 0; i < nb; i++)
+	{
+		part = tab[i].particule_cible;
+		if (tab[i].manual || !tab[i].occupe || part < 1 || part > nb_part)
+			continue;
+		cercle = tab[i].position;
+		if (!nb_robots[part]++)
+		{
+			coin_min[part] = cercle.centre;
+			coin_max[part] = cercle.centre;
+		}
+		coin_min[part].x = fmin(coin_min[part].x, cercle.centre.x);
+		coin_min[part].y = fmin(coin_min[part].y, cercle.centre.y);
+		coin_max[part].x = fmax(coin_max[part].x, cercle.centre.x);
+		coin_max[part].y = fmax(coin_max[part].y, cercle.centre.y);
+	}
+	for (i = 0; i < nb; i++)
+	{
+		part = tab[i].particule_cible;
+		if (tab[i].manual || !tab[i].occupe || part < 1 || part > nb_part ||
+			nb_robots[part] < NAVIGATION_ROBOTS_MIN || masquee[part])
+			continue;
+		masquee[part] = robot_masque(i, particule_position(part));
+	}
+	for (part = 1; part <= nb_part; part++)
+	{
+		if (masquee[part])
+			navigation_construire(part, particule_position(part), coin_min[part],
+								  coin_max[part]);
+	}
+	navigation_terminer();
+}
+
+// vrai si le trajet rectiligne du robot i vers le centre de sa cible touche une
+// autre particule avant elle
+static bool robot_masque(int i, C2D cible)
+{
+	S2D depl = {cible.centre.x - tab[i].position.centre.x,
+				cible.centre.y - tab[i].position.centre.y}, coin_min, coin_max;
+	BALAYAGE balayage = {tab[i].position, depl, 1., 0};
+
+	robot_zone_balayage(&balayage, &coin_min, &coin_max);
+	particule_parcourir_zone(coin_min, coin_max, robot_balayer_particule, &balayage);
+	return balayage.particule && balayage.particule != tab[i].particule_cible;
+}
+
+// "\tx y angle\n"; l'angle est ramené dans [-pi, pi] pour être relu
+static int robot_formater_ligne(char *texte, int i, const void *donnees)
+{
+	const SAUVEGARDE *sauvegarde = donnees;
+	double angle = sauvegarde->angles[i];
+	int n = 0;
+
+	util_range_angle(&angle);
+	texte[n++] = '\t';
+	n += ecriture_reel(&texte[n], sauvegarde->cercles[i].centre.x);
+	texte[n++] = ' ';
+	n += ecriture_reel(&texte[n], sauvegarde->cercles[i].centre.y);
+	texte[n++] = ' ';
+	n += ecriture_reel(&texte[n], angle);
+	texte[n++] = '\n';
+	return n;
 }
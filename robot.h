@@ -14,6 +14,35 @@
 
 #include "utilitaire.h"
 
+// état d'un robot échangé entre des processus qui simulent les mêmes robots:
+// tout ce dont dépendent ses déplacements suivants
+typedef struct Etat_robot ETAT_ROBOT;
+struct Etat_robot
+{
+	S2D position;
+	REEL angle;
+	REEL vrot;
+	REEL vtrans;
+	int particule_cible;
+	bool occupe;
+	bool manual;
+	// progrès vers la cible, voir robot_statistiques_blocages
+	REEL distance_min;
+	int arrets;
+	int arret;
+	REEL normale;
+	bool bloque;
+	int cote;
+	REEL distance_blocage;
+	// trajet en cours, poursuivi au tour suivant s'il est toujours valable
+	S2D ancre;
+	REEL angle_ancre;
+	REEL rotation;
+	S2D pas;
+	S2D but;
+	int parcours;
+};
+
 /**
  * \brief	Configure le nombre de robots. Les indices valides sont dans l'intervalle
  *			[1, nb_robots]. Si nb_robots = 0, les données sont effacées et aucun
@@ -32,11 +61,15 @@ void robot_set_nombre(int nb_robots);
 void robot_set_robot(int i, S2D pos, double angle);
 
 /**
- * \brief			écriture de l'ensemble des robots dans un fichier.
+ * \brief			écriture d'un ensemble de robots dans un fichier, par exemple
+ *					ceux d'une image de la simulation (voir robot_exporter).
  * \param fichier	pointeur vers le fichier ouvert en écriture
-
+ * \param nb_robots	le nombre de robots
+ * \param cercles	les positions des robots
+ * \param angles	les orientations des robots
  */
-void robot_ecrire_fichier(FILE* fichier);
+void robot_ecrire_fichier(FILE* fichier, int nb_robots, const C2D *cercles,
+						  const double *angles);
 
 
 /**
@@ -60,11 +93,37 @@ C2D robot_position(int i);
  */
 double robot_orientation(int i);
 
+/**
+ * \brief	Retourne la particule visée par un robot.
+ * \param i	L'indice du robot, doit être un indice valide.
+ * \return	L'indice de la particule cible, -1 si le robot n'en a pas.
+ */
+int robot_particule_cible(int i);
+
 /**
  * \brief	Dessinne les robots en utilisant les fonctions de dessin de utilitaire.h
  */
 void robot_dessiner(void);
 
+/**
+ * \brief	Copie la position, l'orientation et le mode de contrôle de tous les
+ *			robots, dans l'ordre des indices.
+ * \param cercles	Tableau d'au moins robot_nb_robots() éléments.
+ * \param angles	Tableau d'au moins robot_nb_robots() éléments.
+ * \param manuels	Tableau d'au moins robot_nb_robots() éléments.
+ */
+void robot_exporter(C2D *cercles, double *angles, bool *manuels);
+
+/**
+ * \brief	Dessine un robot dans une pose donnée, indépendamment de l'état de la
+ *			simulation (relecture d'une trajectoire). Rien n'est dessiné si
+ *			le robot est hors de la partie visible.
+ * \param centre	La position du centre du robot.
+ * \param angle		L'orientation du robot.
+ * \param manuel	Vrai pour le dessiner comme un robot contrôlé à la main.
+ */
+void robot_dessiner_pose(S2D centre, double angle, bool manuel);
+
 /**
  * \brief	Contrôle si le robot i est en collision avec l'un des robots 
  *          d'indice inférieur à i.
@@ -102,13 +161,35 @@ void robot_proche(int part);
 void decontamination(int id);
 void deplacement_robot_normal(int i);
 void robot_collision_correction(int i, C2D robot);
-C2D recul_robot(C2D pos_actuelle, int i, C2D cible);
-bool robot_collision_rob_cercle(C2D a, C2D b);
 bool robot_manual(int i);
 void deplacement_robot_manual(int i);
 void changer_vitesse_manual(int id, double rotation, double transition);
 void deselectionner_robot(int id);
 void selectionner_robot(int id);
+
+/**
+ * \brief	Repasse en mode automatique tous les robots contrôlés à la main.
+ */
+void robot_deselectionner_tout(void);
+
+/**
+ * \brief	Retourne le nombre de robots contrôlés à la main.
+ */
+int robot_nb_manuels(void);
+
+/**
+ * \brief	Retourne l'indice d'un robot contrôlé à la main.
+ * \param k	Le rang du robot parmi eux, dans [0, robot_nb_manuels()).
+ */
+int robot_manuel(int k);
+
+/**
+ * \brief	Trouve le robot qui contient un point, par l'index spatial des robots
+ *			sans parcourir les autres.
+ * \param point	Le point, en coordonnées du monde.
+ * \return	Le plus petit indice de robot contenant le point, ou -1.
+ */
+int robot_choisir(S2D point);
 void ajouter_vitesse_rotation(int i);
 void soustraire_vitesse_rotation(int i);
 void ajouter_vitesse_translation(int i);
@@ -117,4 +198,107 @@ double retourner_vtran(int id);
 double chercher_vrot(int id);
 void eliminer_tout_robot(void);
 
+/**
+ * \brief	Active ou désactive le mode évènementiel. Dans ce mode, seuls les robots
+ *			dont le prochain évènement est échu (alignement terminé, contact possible
+ *			avec un autre corps, changement de cible) sont traités à chaque tour;
+ *			les robots en vol libre avancent analytiquement.
+ * \param actif	Vrai pour activer le mode évènementiel.
+ */
+void robot_set_evenementiel(bool actif);
+
+/**
+ * \brief	Indique si le mode évènementiel est actif.
+ */
+bool robot_evenementiel(void);
+
+/**
+ * \brief	Effectue un tour de déplacement et de décontamination en mode
+ *			évènementiel, à la place de la boucle sur tous les robots.
+ */
+void robot_deplacement_evenementiel(void);
+
+/**
+ * \brief	Effectue un tour de déplacement et de décontamination en mode
+ *			standard, sur les seuls robots manuels et robots automatiques ayant
+ *			une cible, par indice croissant.
+ */
+void robot_deplacement_standard(void);
+
+/**
+ * \brief	Donne les robots que la boucle standard traitera au prochain tour.
+ * \param p_actifs	Reçoit leurs rangs dans [0, robot_nb_robots()), croissants;
+ *					le tableau reste valide jusqu'au prochain changement
+ *					d'attribution.
+ * \return	Le nombre de ces robots.
+ */
+int robot_actifs(const int **p_actifs);
+
+/**
+ * \brief	Donne les statistiques des blocages depuis le chargement des robots.
+ *			Un robot est bloqué quand d'autres robots l'arrêtent plusieurs fois
+ *			sans qu'il se rapproche de sa cible; il les contourne alors.
+ * \param p_blocages	Reçoit le nombre de blocages détectés.
+ * \param p_recuperes	Reçoit le nombre de robots qui ont ensuite progressé.
+ */
+void robot_statistiques_blocages(unsigned long *p_blocages,
+								 unsigned long *p_recuperes);
+
+/**
+ * \brief	Donne les statistiques des corrections de déplacement depuis le
+ *			chargement des robots.
+ * \param p_candidats		Reçoit le nombre de robots voisins examinés.
+ * \param p_arrets			Reçoit le nombre de déplacements arrêtés par un contact.
+ * \param p_chevauchements	Reçoit le nombre de chevauchements restés après une
+ *							correction, nul quand tout contact est résolu.
+ */
+void robot_statistiques_contacts(unsigned long *p_candidats,
+								 unsigned long *p_arrets,
+								 unsigned long *p_chevauchements);
+
+/**
+ * \brief	Déplace un robot comme la boucle standard, sans décontamination.
+ * \param i	Le rang du robot, dans [0, robot_nb_robots()).
+ * \return	Le plus grand indice de particule dont le déplacement a dépendu:
+ *			sa cible ou la particule qui l'a arrêté.
+ */
+int robot_deplacer_isole(int i);
+
+/**
+ * \brief	Fait décontaminer sa cible à un robot automatique qui vient d'être
+ *			déplacé par robot_deplacer_isole, comme la boucle standard.
+ * \param i	Le rang du robot, dans [0, robot_nb_robots()).
+ * \return	L'indice de la particule éliminée, 0 si aucune.
+ */
+int robot_decontaminer(int i);
+
+/**
+ * \brief	Relève l'état d'un robot.
+ * \param i		Le rang du robot, dans [0, robot_nb_robots()).
+ * \param etat	Reçoit l'état.
+ */
+void robot_exporter_etat(int i, ETAT_ROBOT *etat);
+
+/**
+ * \brief	Remplace l'état d'un robot par un état relevé par robot_exporter_etat
+ *			dans un processus qui simule les mêmes robots.
+ * \param i		Le rang du robot, dans [0, robot_nb_robots()).
+ * \param etat	L'état relevé.
+ */
+void robot_importer_etat(int i, const ETAT_ROBOT *etat);
+
+/**
+ * \brief	Copie la particule cible de chaque robot, -1 pour un robot sans cible.
+ * \param cibles	Tableau d'au moins robot_nb_robots() éléments.
+ */
+void robot_exporter_cibles(int *cibles);
+
+/**
+ * \brief	Applique une attribution des buts faite par un autre processus qui
+ *			simule les mêmes robots: les robots sont dans le même état qu'après
+ *			attribution_but.
+ * \param cibles	Les cibles copiées par robot_exporter_cibles.
+ */
+void robot_affecter_cibles(const int *cibles);
+
 #endif
@@ -11,14 +11,30 @@
  
 #include <stdio.h>
 #include <string.h>
+#include <math.h>
+#include "arene.h"
 #include "robot.h"
 #include "particule.h"
+#include "trajectoire.h"
+#include "instantane.h"
 #include "utilitaire.h"
+#include "ecriture.h"
 #include "error.h"
 #include "constantes.h"
 #include "simulation.h"
 
 #define LARGEUR_CADRE	5
+#define LIGNES_SUIVI	4096
+
+// demi-largeur du monde, DMAX par défaut ou lue dans le fichier de scénario
+static double dmax = DMAX;
+// appelé par simulation_executer() au début puis tous les periode_observation
+// tours
+static unsigned int periode_observation = 0;
+static void (*observateur)(unsigned int tour) = NULL;
+// appelé par simulation_lecture() toutes les LIGNES_SUIVI lignes, sur le fil qui
+// lit
+static void (*suivi_lecture)(double fraction) = NULL;
 /**
  * \brief états de l'automate de lecture
  * SET_NB_ROBOT		lecture du nombre de robots
@@ -37,8 +53,21 @@ static bool simulation_decodage_particule(int *etat,int nb_particules,char *tab,
 										  
 static bool simulation_decodage_fin_liste(char *tab);
 
+static bool simulation_ligne_dmax(char *tab);
+
+static bool simulation_decodage_dmax(char *tab, int ligne);
+
 static bool simulation_fermeture_fichier_erreur(FILE *file);
 
+static void simulation_dessiner_cadre(double largeur);
+
+static void simulation_capturer(INSTANTANE *instantane, unsigned int tour,
+								double taux);
+
+static long simulation_taille_fichier(FILE *file);
+
+static int simulation_premier_manuel(void);
+
 static bool simulation_decodage_nombre_robots(char *tab,int *i, int *etat,
 											  int *nb_robots,int ligne);
 											  
@@ -49,6 +78,7 @@ bool simulation_lecture(char *nom_fichier)
 {
 	FILE *file = NULL;
 	int nb_robots, nb_particules,etat = SET_NB_ROBOT,ligne = 0,i;
+	long taille;
 	char tab[MAX_LINE];
 	char c;
 	
@@ -57,14 +87,25 @@ bool simulation_lecture(char *nom_fichier)
 		error_file_missing(nom_fichier);
 		return false;
 	}
+	taille = suivi_lecture ? simulation_taille_fichier(file) : 0;
+	dmax = DMAX;
 	while (fgets(tab,MAX_LINE,file))
 	{
 		++ligne;
+		if (suivi_lecture && taille > 0 && ligne % LIGNES_SUIVI == 0)
+			suivi_lecture((double)ftell(file)/taille);
 		if (sscanf(tab," %c",&c)!=1 || c == '#')
 			continue;
 		switch(etat)
 		{
 		case SET_NB_ROBOT :
+			// la taille du monde peut précéder le nombre de robots
+			if (simulation_ligne_dmax(tab))
+			{
+				if (!simulation_decodage_dmax(tab,ligne))
+					return simulation_fermeture_fichier_erreur(file);
+				break;
+			}
 			if (!simulation_decodage_nombre_robots(tab,&i,&etat,&nb_robots,ligne))
 				return simulation_fermeture_fichier_erreur(file);
 			break;
@@ -99,42 +140,143 @@ bool simulation_lecture(char *nom_fichier)
 }
 
 void simulation_ecriture(char *nom_fichier)
+{
+	INSTANTANE instantane = {0};
+
+	simulation_capturer(&instantane, 0, 0.);
+	simulation_ecriture_instantane(nom_fichier, &instantane);
+	instantane_liberer(&instantane);
+}
+
+// n'utilise que l'image: peut s'exécuter sur un autre fil que la simulation
+bool simulation_ecriture_instantane(const char *nom_fichier,
+									const INSTANTANE *instantane)
 {
 	FILE *fichier;
+	char reel[ECRITURE_REEL_MAX];
 	
-	if((fichier = fopen(nom_fichier, "w")))
+	if(!(fichier = fopen(nom_fichier, "w")))
+		return false;
+	if (instantane->dmax != DMAX)
 	{
-		robot_ecrire_fichier(fichier);
-		particule_ecrire_fichier(fichier);
-
-		fclose(fichier);
+		ecriture_reel(reel, instantane->dmax);
+		fprintf(fichier, "DMAX %s\n", reel);
 	}
+	robot_ecrire_fichier(fichier, instantane->nb_robots, instantane->robots,
+						 instantane->angles);
+	particule_ecrire_fichier(fichier, instantane->nb_particules,
+							 instantane->particules, instantane->energies);
+	return fclose(fichier) == 0;
+}
+
+void simulation_set_suivi_lecture(void (*suivre)(double fraction))
+{
+	suivi_lecture = suivre;
 }
 
 void simulation_dessiner(void)
 {
-	util_debut_dessin(-DMAX, DMAX, -DMAX, DMAX);
+	simulation_dessiner_cadre(dmax);
+
+	robot_dessiner();
+
+	particule_dessiner();
+
+	util_fin_dessin();
+}
+
+void simulation_dessiner_replay(const LECTEUR *lecteur)
+{
+	int i;
+	POSE pose;
+
+	simulation_dessiner_cadre(trajectoire_lecteur_dmax(lecteur));
+
+	for (i = 1; i <= trajectoire_lecteur_nb_robots(lecteur); i++)
+	{
+		pose = trajectoire_lecteur_robot(lecteur, i);
+		robot_dessiner_pose(pose.centre, pose.angle, false);
+	}
+
+	for (i = 1; i <= trajectoire_lecteur_nb_particules(lecteur); i++)
+		particule_dessiner_cercle(trajectoire_lecteur_particule(lecteur, i));
+
+	util_fin_dessin();
+}
+
+void simulation_publier(unsigned int tour, double taux)
+{
+	simulation_capturer(instantane_ecriture(), tour, taux);
+	instantane_publier();
+}
+
+void simulation_dessiner_instantane(const INSTANTANE *instantane)
+{
+	int i;
+
+	simulation_dessiner_cadre(instantane->dmax);
+
+	for (i = 0; i < instantane->nb_robots; i++)
+		robot_dessiner_pose(instantane->robots[i].centre, instantane->angles[i],
+							instantane->manuels[i]);
+
+	for (i = 0; i < instantane->nb_particules; i++)
+		particule_dessiner_cercle(instantane->particules[i]);
+
+	util_fin_dessin();
+}
+
+double simulation_dmax(void)
+{
+	return dmax;
+}
+
+static void simulation_capturer(INSTANTANE *instantane, unsigned int tour,
+								double taux)
+{
+	instantane_reserver(instantane, robot_nb_robots(), particule_nb_particules());
+	instantane->tour = tour;
+	instantane->taux = taux;
+	instantane->dmax = dmax;
+	instantane->vitesse_rotation = vitesse_angle();
+	instantane->vitesse_translation = vitesse_transition();
+	instantane->nb_robots = robot_nb_robots();
+	instantane->nb_particules = particule_nb_particules();
+	robot_exporter(instantane->robots, instantane->angles, instantane->manuels);
+	particule_exporter(instantane->particules, instantane->energies);
+}
+
+// la position de lecture est remise au début
+static long simulation_taille_fichier(FILE *file)
+{
+	long taille;
+
+	if (fseek(file, 0, SEEK_END) || (taille = ftell(file)) < 0 ||
+		fseek(file, 0, SEEK_SET))
+		return 0;
+	return taille;
+}
+
+static void simulation_dessiner_cadre(double largeur)
+{
+	util_debut_dessin(-largeur, largeur, -largeur, largeur);
 
 	COULEUR noir = {0., 0., 0.};
-	S2D hg = {-DMAX, -DMAX};
-	S2D hd = { DMAX, -DMAX};
-	S2D bg = {-DMAX,  DMAX};
-	S2D bd = { DMAX,  DMAX};
+	S2D hg = {-largeur, -largeur};
+	S2D hd = { largeur, -largeur};
+	S2D bg = {-largeur,  largeur};
+	S2D bd = { largeur,  largeur};
 	util_dessiner_segment(hg, hd, noir, LARGEUR_CADRE);
 	util_dessiner_segment(hd, bd, noir, LARGEUR_CADRE);
 	util_dessiner_segment(bd, bg, noir, LARGEUR_CADRE);
 	util_dessiner_segment(bg, hg, noir, LARGEUR_CADRE);
-
-	robot_dessiner();
-
-	particule_dessiner();
 }
 
 static bool simulation_decodage_robot(int *etat,int nb_robots, char *tab,int *i,
 									  int ligne)
 {
 	S2D pos;
-	double angle;
+	double x, y, angle;
 	int offset = 0, n;
 	if(simulation_decodage_fin_liste(tab))
 	{
@@ -152,14 +294,19 @@ static bool simulation_decodage_robot(int *etat,int nb_robots, char *tab,int *i,
 		return false;
 	}
 	// %n Receives an integer of value equal to the number of characters read so far
-    while(sscanf(&tab[offset]," %lf %lf %lf %n",&pos.x,&pos.y,&angle, &n)==3)
+    while(sscanf(&tab[offset]," %lf %lf %lf %n",&x,&y,&angle, &n)==3)
 	{
+		pos.x = x;
+		pos.y = y;
 		if(util_alpha_dehors(angle))
 		{
 			error_invalid_robot_angle(angle);
 			return false;
 		}
-		util_range_angle(&angle);
+		// un angle déjà dans ]-pi, pi] est gardé tel quel: le réduire l'ajusterait
+		// à l'arrondi près et le fichier ne se relirait plus à l'identique
+		if(angle <= -M_PI)
+			util_range_angle(&angle);
 		robot_set_robot(++(*i), pos, angle);
 		
 		if(robot_collision(*i))
@@ -184,7 +331,7 @@ static bool simulation_decodage_particule(int *etat,int nb_particules,char *tab,
 										  int ligne)
 {
 	C2D pos;
-	double energie;
+	double energie, rayon, x, y;
 	int offset = 0, n;
 	if(simulation_decodage_fin_liste(tab))
 	{
@@ -202,12 +349,16 @@ static bool simulation_decodage_particule(int *etat,int nb_particules,char *tab,
 		return false;
 	}
 	// %n Receives an integer of value equal to the number of characters read so far
-    while(sscanf(&tab[offset], " %lf %lf %lf  %lf %n ", &energie, &pos.rayon,
-				 &pos.centre.x, &pos.centre.y, &n)==4)
+    while(sscanf(&tab[offset], " %lf %lf %lf  %lf %n ", &energie, &rayon,
+				 &x, &y, &n)==4)
 	{
-		if (!particule_is_valid(pos, energie))
+		pos.centre.x = x;
+		pos.centre.y = y;
+		pos.rayon = rayon;
+		if (!particule_is_valid(pos, energie, dmax))
 		{
-			error_invalid_particule_value(energie,pos.rayon,pos.centre.x,pos.centre.y);
+			error_invalid_particule_value(energie,pos.rayon,pos.centre.x,pos.centre.y,
+										  dmax);
 			return false;
 		}
 		particule_set_particule(++(*i),pos,energie);
@@ -235,7 +386,7 @@ static bool simulation_decodage_particule(int *etat,int nb_particules,char *tab,
 
 static bool simulation_decodage_fin_liste(char *tab)
 {
-	int n;
+	int n = 0;
     sscanf(tab," FIN_LISTE %n",&n);
     if (n != strlen(tab))
 		return false;
@@ -243,6 +394,31 @@ static bool simulation_decodage_fin_liste(char *tab)
 		return true;	
 }
 
+static bool simulation_ligne_dmax(char *tab)
+{
+	int n = 0;
+	sscanf(tab, " DMAX%n", &n);
+	return n > 0;
+}
+
+static bool simulation_decodage_dmax(char *tab, int ligne)
+{
+	double valeur;
+	int n;
+	if (sscanf(tab, " DMAX %lf %n", &valeur, &n) != 1 || !(valeur > 0))
+	{
+		error_invalid_dmax(ligne);
+		return false;
+	}
+	if (n != strlen(tab))
+	{
+		error_useless_char(ligne);
+		return false;
+	}
+	dmax = valeur;
+	return true;
+}
+
 static bool simulation_fermeture_fichier_erreur(FILE *file)
 {
 	if(!fclose(file)==0)
@@ -294,38 +470,64 @@ static bool simulation_decodage_nombre_particules(char *tab,int *i,int *etat,
 
 void simulation_deplacement(void)
 {
-    int i;
     int nb_part = particule_nb_particules();
 
+    arene_reinitialiser();
     if (nb_part==0)
 		return;
    
-    int nb_robot = robot_nb_robots();
-    for (i=0; i<nb_robot; i++)
-    {
-        if (robot_manual(i))
-        {
-			deplacement_robot_manual(i);
-		}
-		else
-		{
-			deplacement_robot_normal(i);
-			decontamination(i);
-		}
-    }
+    if (robot_evenementiel())
+		robot_deplacement_evenementiel();
+	else
+		robot_deplacement_standard();
     if (update_nb_part())
     {
         set_robot_occupe();
         attribution_but();
     }
     decomposition();
+    trajectoire_enregistrer_tour();
 }
 
 void but_initial(void)
 {
+    arene_reinitialiser();
     attribution_but();
 }
 
+void simulation_set_evenementiel(bool actif)
+{
+	robot_set_evenementiel(actif);
+}
+
+void simulation_set_observateur(unsigned int periode,
+								void (*observer)(unsigned int tour))
+{
+	periode_observation = periode;
+	observateur = periode ? observer : NULL;
+}
+
+double simulation_executer(unsigned int nb_tours_max, unsigned int *p_tours)
+{
+	double Td = 0., Si, Sd = 0.;
+	unsigned int tours = 0;
+
+	but_initial();
+	if (observateur)
+		observateur(tours);
+	Si = somme_des_energies();
+	while (Si > 0 && Td < CENT_POUR_CENT && tours < nb_tours_max)
+	{
+		simulation_deplacement();
+		update_taux_decontamination(&Td, &Si, &Sd);
+		tours++;
+		if (observateur && tours % periode_observation == 0)
+			observateur(tours);
+	}
+	*p_tours = tours;
+	return Td;
+}
+
 bool manual_robot(int id)
 {
 	return robot_manual(id);
@@ -333,12 +535,20 @@ bool manual_robot(int id)
 
 double somme_des_energies(void)
 {
-	double somme;
-	for (int i=1; i <= particule_nb_particules(); i++)
-	{
-		somme += particule_energie(i);
-	}
-	return somme;
+	return particule_energie_totale();
+}
+
+void simulation_statistiques_blocages(unsigned long *p_blocages,
+									  unsigned long *p_recuperes)
+{
+	robot_statistiques_blocages(p_blocages, p_recuperes);
+}
+
+void simulation_statistiques_contacts(unsigned long *p_candidats,
+									  unsigned long *p_arrets,
+									  unsigned long *p_chevauchements)
+{
+	robot_statistiques_contacts(p_candidats, p_arrets, p_chevauchements);
 }
 
 
@@ -365,37 +575,40 @@ void update_taux_decontamination (double*Td, double*Si, double*Sd)
 void simulation_selectioner_robot (int x, int y)
 {
 	S2D mouse_position;
-	int robot_selection=-1;
 	utilitaire_conversion(x,y, &mouse_position.x, &mouse_position.y);
-	for (int i=0; i<robot_nb_robots(); i++)
-		{	
-			if (robot_manual(i))
-			{
-				robot_selection=i;
-				deselectionner_robot(i);
-			}
-		}
-	for (int i=0; i<robot_nb_robots(); i++)
+	simulation_selectioner_point(mouse_position);
+}
+
+// le robot choisi est cherché dans l'index spatial des robots, et seuls les
+// robots manuels sont désélectionnés
+void simulation_selectioner_point(S2D mouse_position)
+{
+	int robot_selection=-1;
+	int choisi = robot_choisir(mouse_position);
+
+	for (int k=0; k<robot_nb_manuels(); k++)
 	{
-		if (util_point_dans_cercle(mouse_position, robot_position(i+1)))
-		{
-			if (robot_selection !=i)
-			{
-				selectionner_robot(i);
-			}
-			else 
-			{
-				deselectionner_robot(i);
-			}
-			return;
-		}
+		if (robot_manuel(k) > robot_selection)
+			robot_selection = robot_manuel(k);
 	}
+	robot_deselectionner_tout();
+	if (choisi >= 0 && choisi != robot_selection)
+		selectionner_robot(choisi);
 }	
 
 void deselectionner_tout(void)
 {
-	for (int i=0; i< robot_nb_robots(); i++)
-		deselectionner_robot(i);
+	robot_deselectionner_tout();
+}
+
+int simulation_nb_manuels(void)
+{
+	return robot_nb_manuels();
+}
+
+int simulation_robot_manuel(int k)
+{
+	return robot_manuel(k);
 }
 
 void simulation_ajouter_vitesse_rotation(int i)
@@ -431,32 +644,31 @@ int simulation_nombre_robot(void)
 	return robot_nb_robots();
 }
 
+// vitesses du robot manuel de plus petit indice
 double vitesse_angle(void)
 {
-	double vitesse=0;
-	for (int i=0; i<robot_nb_robots(); i++)
-	{
-		if (robot_manual(i))
-		{
-			vitesse = chercher_vrot(i);
-			break;
-		}
-	}
-	return vitesse;
+	int premier = simulation_premier_manuel();
+
+	return premier < 0 ? 0 : chercher_vrot(premier);
 }
 
 double vitesse_transition(void)
 {
-	double vitesse=0;
-	for (int i=0; i<robot_nb_robots(); i++)
+	int premier = simulation_premier_manuel();
+
+	return premier < 0 ? 0 : retourner_vtran(premier);
+}
+
+static int simulation_premier_manuel(void)
+{
+	int premier = -1;
+
+	for (int k=0; k<robot_nb_manuels(); k++)
 	{
-		if (robot_manual(i))
-		{
-			vitesse = retourner_vtran(i);
-			break;
-		}
+		if (premier < 0 || robot_manuel(k) < premier)
+			premier = robot_manuel(k);
 	}
-	return vitesse;
+	return premier;
 }
 
 void eliminer_tout(void)
@@ -12,6 +12,8 @@
 #define SIMULATION_H
 
 #include <stdbool.h>
+#include "trajectoire.h"
+#include "instantane.h"
 
 
 /**
@@ -29,24 +31,130 @@ bool simulation_lecture(char *nom_fichier);
  */
 void simulation_ecriture(char *nom_fichier);
 
+/**
+ * \brief	Écrit une image de la simulation dans un fichier lisible, sans
+ *			accéder à la simulation elle-même: l'écriture peut se faire sur un
+ *			autre fil pendant que la simulation continue.
+ * \param nom_fichier	Le nom du fichier à écrire.
+ * \param instantane	L'image à écrire, avec les énergies des particules.
+ * \return	Vrai si le fichier a été écrit en entier.
+ */
+bool simulation_ecriture_instantane(const char *nom_fichier,
+									const INSTANTANE *instantane);
+
+/**
+ * \brief	Fait appeler une fonction pendant simulation_lecture(), sur le fil
+ *			qui lit, avec la fraction du fichier déjà lue.
+ * \param suivre	La fonction, ou NULL pour ne plus suivre la lecture.
+ */
+void simulation_set_suivi_lecture(void (*suivre)(double fraction));
+
 /**
  * \brief	Dessine l'état actuel de la simulation.
  */
 void simulation_dessiner(void);
 
+/**
+ * \brief	Dessine le tour courant d'une trajectoire enregistrée, dans le cadre
+ *			du monde où elle a été enregistrée, sans toucher à la simulation.
+ * \param lecteur	Le lecteur, placé sur le tour à dessiner.
+ */
+void simulation_dessiner_replay(const LECTEUR *lecteur);
+
+/**
+ * \brief	Publie l'état courant dans le triple tampon d'images pour l'affichage.
+ *			Les positions sont écrites directement dans le tampon d'écriture.
+ * \param tour	Le numéro du tour, affiché avec l'image.
+ * \param taux	Le taux de décontamination, affiché avec l'image.
+ */
+void simulation_publier(unsigned int tour, double taux);
+
+/**
+ * \brief	Dessine une image publiée, sans lire l'état de la simulation: le
+ *			tour suivant peut être calculé pendant ce temps sur un autre fil.
+ * \param instantane	L'image détenue par le consommateur.
+ */
+void simulation_dessiner_instantane(const INSTANTANE *instantane);
+
+/**
+ * \brief	Retourne la demi-largeur du monde de la simulation chargée.
+ */
+double simulation_dmax(void);
+
 void simulation_deplacement(void);
 void but_initial(void);
+
+/**
+ * \brief	Active le mode évènementiel: seuls les robots ayant un évènement échu
+ *			sont traités à chaque tour, les autres avancent analytiquement.
+ * \param actif	Vrai pour activer le mode évènementiel.
+ */
+void simulation_set_evenementiel(bool actif);
+
+/**
+ * \brief	Exécute la simulation chargée sans affichage, dans le mode choisi par
+ *			simulation_set_evenementiel (standard par défaut), jusqu'à
+ *			décontamination complète ou nb_tours_max tours.
+ * \param nb_tours_max	Le nombre maximal de tours.
+ * \param p_tours		Reçoit le nombre de tours effectués.
+ * \return	Le taux de décontamination atteint, en pour cent.
+ */
+double simulation_executer(unsigned int nb_tours_max, unsigned int *p_tours);
+
+/**
+ * \brief	Fait appeler une fonction par simulation_executer() avant le premier
+ *			tour puis tous les periode tours, par exemple pour produire une image.
+ * \param periode	La période en tours, 0 pour ne plus rien appeler.
+ * \param observer	La fonction, qui reçoit le nombre de tours effectués.
+ */
+void simulation_set_observateur(unsigned int periode,
+								void (*observer)(unsigned int tour));
+
+/**
+ * \brief	Donne le nombre de robots détectés bloqués depuis le chargement et
+ *			le nombre de ceux qui ont ensuite progressé.
+ */
+void simulation_statistiques_blocages(unsigned long *p_blocages,
+									  unsigned long *p_recuperes);
+
+/**
+ * \brief	Donne les statistiques des contacts entre robots depuis le
+ *			chargement: voisins examinés, déplacements arrêtés et chevauchements
+ *			restés après correction.
+ */
+void simulation_statistiques_contacts(unsigned long *p_candidats,
+									  unsigned long *p_arrets,
+									  unsigned long *p_chevauchements);
+
 bool manual_robot(int id);
 double somme_des_energies(void);
 void record_ecriture( int count, double Td);
 void update_taux_decontamination (double*Td, double*Si, double*Sd);
 void simulation_selectioner_robot (int x, int y);
+
+/**
+ * \brief	Sélectionne le robot sous un point du monde, ou le désélectionne s'il
+ *			l'était déjà. La conversion depuis la fenêtre reste sur le fil de
+ *			l'affichage.
+ * \param mouse_position	Le point, en coordonnées du monde.
+ */
+void simulation_selectioner_point(S2D mouse_position);
 int simulation_nombre_robot(void);
 void simulation_ajouter_vitesse_rotation(int i);
 void simulation_soustraire_vitesse_rotation(int i);
 void simulation_augmenter_vitesse_translation(int i);
 void simulation_soustraire_vitesse_translation(int i);
 void deselectionner_tout(void);
+
+/**
+ * \brief	Retourne le nombre de robots contrôlés à la main.
+ */
+int simulation_nb_manuels(void);
+
+/**
+ * \brief	Retourne l'indice du k-ième robot contrôlé à la main.
+ */
+int simulation_robot_manuel(int k);
 double vitesse_angle(void);
 double vitesse_transition(void);
 void eliminer_tout(void);
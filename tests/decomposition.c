@@ -0,0 +1,105 @@
+/*!
+ \file decomposition.c
+ \brief Test de la loi des décompositions: le tour où une particule se
+        décompose doit suivre la loi géométrique d'un tirage de Bernoulli
+        à chaque tour, de chance DECOMPOSITION_RATE au pas de référence
+ \author agent
+ \group Sylvain Pellegrini
+		Simon Gilgien
+ \version 1.0
+ \date 19 octobre 2026
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include "constantes.h"
+#include "particule.h"
+
+// les enfants d'une particule de rayon 1 sont trop petits pour se décomposer:
+// chaque décomposition ajoute exactement trois particules à la liste
+#define NB_PARTICULES	20000
+#define RAYON			1.
+#define NB_TOURS		300
+#define EFFECTIF_MIN	5.
+// seuils au niveau 0.1%: Kolmogorov-Smirnov et khi-deux (approximation
+// normale, ddl + 3.1*sqrt(2*ddl))
+#define SEUIL_KS		1.95
+#define SEUIL_KHI2		3.1
+
+static int survivantes(void);
+
+// compare l'histogramme des délais de décomposition à N*p*(1-p)^(m-1), et la
+// proportion de particules intactes après m tours à (1-p)^m
+int main(int argc, char *argv[])
+{
+	int survivantes_tour[NB_TOURS+1], i, m, ddl = -1;
+	double p = 1 - pow(1 - DECOMPOSITION_RATE, DELTA_T/DELTA_T_REFERENCE);
+	double ecart, ecart_max = 0., khi2 = 0.;
+	double attendu = 0., observe = 0.;
+	C2D pos;
+	
+	srand(argc > 1 ? atoi(argv[1]) : 1);
+	particule_set_nombre(NB_PARTICULES);
+	for(i = 1; i <= NB_PARTICULES; i++)
+	{
+		pos.centre.x = 3*RAYON*(i%100);
+		pos.centre.y = 3*RAYON*(i/100);
+		pos.rayon = RAYON;
+		particule_set_particule(i, pos, E_PARTICULE_MAX);
+	}
+	survivantes_tour[0] = survivantes();
+	for(m = 1; m <= NB_TOURS; m++)
+	{
+		decomposition();
+		if((particule_nb_particules() - NB_PARTICULES) % 3)
+		{
+			printf("tour %d: %d particules, décomposition incomplète\n", m,
+				   particule_nb_particules());
+			return EXIT_FAILURE;
+		}
+		survivantes_tour[m] = survivantes();
+		ecart = fabs((double)survivantes_tour[m]/NB_PARTICULES - pow(1-p, m));
+		if(ecart > ecart_max)
+			ecart_max = ecart;
+	}
+	// les classes d'effectif attendu trop faible sont regroupées avec les
+	// suivantes; la dernière classe compte les particules encore intactes
+	for(m = 1; m <= NB_TOURS+1; m++)
+	{
+		if(m <= NB_TOURS)
+		{
+			attendu += NB_PARTICULES*p*pow(1-p, m-1);
+			observe += survivantes_tour[m-1] - survivantes_tour[m];
+		}
+		else
+		{
+			attendu += NB_PARTICULES*pow(1-p, NB_TOURS);
+			observe += survivantes_tour[NB_TOURS];
+		}
+		if(attendu >= EFFECTIF_MIN || m == NB_TOURS+1)
+		{
+			khi2 += (observe - attendu)*(observe - attendu)/attendu;
+			ddl++;
+			attendu = 0.;
+			observe = 0.;
+		}
+	}
+	printf("KS %.4f (seuil %.4f), khi2 %.1f sur %d ddl (seuil %.1f)\n",
+		   ecart_max, SEUIL_KS/sqrt(NB_PARTICULES), khi2, ddl,
+		   ddl + SEUIL_KHI2*sqrt(2.*ddl));
+	if(ecart_max > SEUIL_KS/sqrt(NB_PARTICULES) ||
+	   khi2 > ddl + SEUIL_KHI2*sqrt(2.*ddl))
+	{
+		printf("échec: les délais ne suivent pas la loi géométrique\n");
+		return EXIT_FAILURE;
+	}
+	particule_set_nombre(0);
+	return EXIT_SUCCESS;
+}
+
+// particules de départ pas encore décomposées
+static int survivantes(void)
+{
+	return NB_PARTICULES - (particule_nb_particules() - NB_PARTICULES)/3;
+}
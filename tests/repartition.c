@@ -0,0 +1,166 @@
+/*!
+ \file repartition.c
+ \brief Test de la répartition en bandes et du mode évènementiel: l'état
+        final doit être celui de la boucle standard en un seul processus
+ \author agent
+ \group Sylvain Pellegrini
+		Simon Gilgien
+ \version 1.0
+ \date 19 octobre 2026
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "simulation.h"
+#include "robot.h"
+#include "particule.h"
+#include "repartition.h"
+
+#define GRAINE		1
+#define TAUX_MAX	100.
+#define EVENEMENTIEL	-1		// variante du mode évènementiel, notée E
+
+typedef struct
+{
+	unsigned int tours;
+	double taux;
+	int nb_robots;
+	int nb_particules;
+	C2D *robots;
+	double *angles;
+	int *cibles;
+	C2D *particules;
+	double *energies;
+} RESULTAT;
+
+static bool executer(char *scenario, int nb_travailleurs,
+					 unsigned int nb_tours, RESULTAT *resultat);
+
+static int comparer(const RESULTAT *a, const RESULTAT *b);
+
+static void liberer(RESULTAT *resultat);
+
+// repartition scenario nb_tours variante...   une variante est un nombre de
+// travailleurs, ou E pour le mode évènementiel; échoue si une variante donne
+// un état final différent du mode standard
+int main(int argc, char *argv[])
+{
+	RESULTAT reference, resultat;
+	int k, nb_travailleurs, ecart;
+	unsigned int nb_tours;
+
+	if(argc < 4)
+	{
+		printf("Usage : %s scenario nb_tours {nb_travailleurs|E}...\n", argv[0]);
+		return EXIT_FAILURE;
+	}
+	nb_tours = atoi(argv[2]);
+	if(!executer(argv[1], 0, nb_tours, &reference))
+		return EXIT_FAILURE;
+	for(k = 3; k < argc; k++)
+	{
+		nb_travailleurs = strcmp(argv[k], "E") ? atoi(argv[k]) : EVENEMENTIEL;
+		if(!executer(argv[1], nb_travailleurs, nb_tours, &resultat))
+		{
+			printf("%s: échec de la variante %s\n", argv[1], argv[k]);
+			return EXIT_FAILURE;
+		}
+		if((ecart = comparer(&reference, &resultat)))
+		{
+			printf("%s: variante %s, %d écarts avec le mode standard\n",
+				   argv[1], argv[k], ecart);
+			return EXIT_FAILURE;
+		}
+		liberer(&resultat);
+	}
+	printf("%s: %u tours, taux %.3lf, identiques en variantes", argv[1],
+		   reference.tours, reference.taux);
+	for(k = 3; k < argc; k++)
+		printf(" %s", argv[k]);
+	printf("\n");
+	liberer(&reference);
+	return EXIT_SUCCESS;
+}
+
+// nb_travailleurs = 0 pour le mode standard et EVENEMENTIEL pour le mode
+// évènementiel, avec la boucle de simulation_executer; la graine est la même
+// pour rejouer la décomposition
+static bool executer(char *scenario, int nb_travailleurs,
+					 unsigned int nb_tours, RESULTAT *resultat)
+{
+	double Si, Sd = 0.;
+	int i;
+
+	srand(GRAINE);
+	if(!simulation_lecture(scenario))
+		return false;
+	resultat->tours = 0;
+	resultat->taux = 0.;
+	if(nb_travailleurs > 0)
+	{
+		if(!repartition_executer(nb_travailleurs, nb_tours, &resultat->tours,
+								 &resultat->taux))
+			return false;
+	}
+	else
+	{
+		simulation_set_evenementiel(nb_travailleurs == EVENEMENTIEL);
+		but_initial();
+		Si = somme_des_energies();
+		while(Si > 0 && resultat->taux < TAUX_MAX && resultat->tours < nb_tours)
+		{
+			simulation_deplacement();
+			update_taux_decontamination(&resultat->taux, &Si, &Sd);
+			resultat->tours++;
+		}
+	}
+	resultat->nb_robots = robot_nb_robots();
+	resultat->nb_particules = particule_nb_particules();
+	if(!(resultat->robots = malloc((resultat->nb_robots + 1)*sizeof(C2D))) ||
+	   !(resultat->angles = malloc((resultat->nb_robots + 1)*sizeof(double))) ||
+	   !(resultat->cibles = malloc((resultat->nb_robots + 1)*sizeof(int))) ||
+	   !(resultat->particules = malloc((resultat->nb_particules + 1)*sizeof(C2D))) ||
+	   !(resultat->energies = malloc((resultat->nb_particules + 1)*sizeof(double))))
+		exit(EXIT_FAILURE);
+	for(i = 0; i < resultat->nb_robots; i++)
+	{
+		resultat->robots[i] = robot_position(i + 1);
+		resultat->angles[i] = robot_orientation(i + 1);
+		resultat->cibles[i] = robot_particule_cible(i + 1);
+	}
+	particule_exporter(resultat->particules, resultat->energies);
+	return true;
+}
+
+// compte les grandeurs qui diffèrent, exactement: les deux simulations font
+// les mêmes calculs dans le même ordre, le mode évènementiel les mêmes calculs
+// pour chaque robot
+static int comparer(const RESULTAT *a, const RESULTAT *b)
+{
+	int i, ecart = (a->tours != b->tours) + (a->taux != b->taux);
+
+	if(a->nb_robots != b->nb_robots || a->nb_particules != b->nb_particules)
+		return ecart + 1;
+	for(i = 0; i < a->nb_robots; i++)
+	{
+		ecart += memcmp(&a->robots[i], &b->robots[i], sizeof(C2D)) != 0;
+		ecart += a->angles[i] != b->angles[i];
+		ecart += a->cibles[i] != b->cibles[i];
+	}
+	for(i = 0; i < a->nb_particules; i++)
+	{
+		ecart += memcmp(&a->particules[i], &b->particules[i], sizeof(C2D)) != 0;
+		ecart += a->energies[i] != b->energies[i];
+	}
+	return ecart;
+}
+
+static void liberer(RESULTAT *resultat)
+{
+	free(resultat->robots);
+	free(resultat->angles);
+	free(resultat->cibles);
+	free(resultat->particules);
+	free(resultat->energies);
+}
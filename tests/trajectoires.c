@@ -0,0 +1,139 @@
+/*!
+ \file trajectoires.c
+ \brief Test de tolérance des trajectoires: enregistre la pose des robots à
+        chaque tour et le bilan de la mission, ou les compare à un
+        enregistrement de référence
+ \author agent
+ \group Sylvain Pellegrini
+		Simon Gilgien
+ \version 1.0
+ \date 19 octobre 2026
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "simulation.h"
+#include "robot.h"
+#include "particule.h"
+
+static double ecart_angle(double a, double b);
+static int comparer_bilan(const char *scenario, FILE *reference, int tours,
+						  double taux, double tolerance);
+
+// trajectoires scenario nb_tours sortie         écrit "tour robot x y angle"
+//                                               puis "bilan tours taux"
+// trajectoires scenario nb_tours ref tolerance  compare à ref, échoue au-delà
+// de la tolérance sur la position ou l'orientation d'un robot
+// trajectoires scenario nb_tours ref bilan tolerance  compare seulement le
+// bilan: même taux, écart relatif des tours au plus égal à la tolérance
+int main(int argc, char *argv[])
+{
+	FILE *sortie = NULL, *reference = NULL;
+	int nb_tours, tour, i, tour_ref, robot_ref, tour_max = 0;
+	double tolerance = 0., x, y, angle, ecart, ecart_max = 0.;
+	double taux = 0., Si, Sd = 0.;
+	bool bilan = argc == 6 && strcmp(argv[4], "bilan") == 0;
+	C2D cercle;
+	
+	if(argc != 4 && argc != 5 && !bilan)
+	{
+		printf("Usage : %s scenario nb_tours "
+			   "{sortie|reference [bilan] tolerance}\n", argv[0]);
+		return EXIT_FAILURE;
+	}
+	nb_tours = atoi(argv[2]);
+	if(argc == 4 && !(sortie = fopen(argv[3], "w")))
+	{
+		printf("%s: écriture impossible\n", argv[3]);
+		return EXIT_FAILURE;
+	}
+	if(argc >= 5)
+	{
+		if(!(reference = fopen(argv[3], "r")))
+		{
+			printf("%s: référence introuvable\n", argv[3]);
+			return EXIT_FAILURE;
+		}
+		tolerance = atof(argv[argc - 1]);
+	}
+	if(!simulation_lecture(argv[1]))
+		return EXIT_FAILURE;
+	but_initial();
+	Si = somme_des_energies();
+	for(tour = 1; tour <= nb_tours && particule_nb_particules(); tour++)
+	{
+		simulation_deplacement();
+		update_taux_decontamination(&taux, &Si, &Sd);
+		for(i = 1; i <= robot_nb_robots() && !bilan; i++)
+		{
+			cercle = robot_position(i);
+			if(sortie)
+			{
+				fprintf(sortie, "%d %d %.17g %.17g %.17g\n", tour, i,
+						cercle.centre.x, cercle.centre.y, robot_orientation(i));
+				continue;
+			}
+			if(fscanf(reference, "%d %d %lf %lf %lf", &tour_ref, &robot_ref, &x,
+					  &y, &angle) != 5 || tour_ref != tour || robot_ref != i)
+			{
+				printf("%s: la référence s'arrête ou diverge au tour %d\n",
+					   argv[1], tour);
+				return EXIT_FAILURE;
+			}
+			ecart = fmax(fmax(fabs(cercle.centre.x - x), fabs(cercle.centre.y - y)),
+						 ecart_angle(robot_orientation(i), angle));
+			if(ecart > ecart_max)
+			{
+				ecart_max = ecart;
+				tour_max = tour;
+			}
+		}
+	}
+	if(sortie)
+	{
+		fprintf(sortie, "bilan %d %.17g\n", tour - 1, taux);
+		return fclose(sortie) == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+	}
+	if(bilan)
+		return comparer_bilan(argv[1], reference, tour - 1, taux, tolerance);
+	fclose(reference);
+	printf("%s: écart max %.3g au tour %d (tolérance %g)\n", argv[1], ecart_max,
+		   tour_max, tolerance);
+	return ecart_max <= tolerance ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+static double ecart_angle(double a, double b)
+{
+	double ecart = fmod(fabs(a - b), 2*M_PI);
+	
+	return fmin(ecart, 2*M_PI - ecart);
+}
+
+// cherche la ligne "bilan tours taux" de la référence: les trajectoires
+// peuvent diverger après une décision prise au seuil, mais la mission doit
+// atteindre le même taux en un nombre de tours voisin
+static int comparer_bilan(const char *scenario, FILE *reference, int tours,
+						  double taux, double tolerance)
+{
+	char ligne[128];
+	int tours_ref = -1;
+	double taux_ref = 0., ecart;
+	
+	while(fgets(ligne, sizeof(ligne), reference))
+		if(sscanf(ligne, "bilan %d %lf", &tours_ref, &taux_ref) == 2)
+			break;
+	fclose(reference);
+	if(tours_ref < 0)
+	{
+		printf("%s: bilan absent de la référence\n", scenario);
+		return EXIT_FAILURE;
+	}
+	ecart = fabs((double)(tours - tours_ref))/fmax(tours_ref, 1);
+	printf("%s: %d tours au lieu de %d (écart %.3g, tolérance %g), "
+		   "taux %.3f au lieu de %.3f\n", scenario, tours, tours_ref, ecart,
+		   tolerance, taux, taux_ref);
+	return ecart <= tolerance && fabs(taux - taux_ref) < 1e-3 ?
+		   EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,774 @@
+/*!
+ \file trajectoire.c
+ \brief Module d'enregistrement et de relecture des trajectoires: poses des
+        robots à chaque tour, naissances et disparitions des particules
+ \author agent
+ \group Sylvain Pellegrini
+		Simon Gilgien
+ \version 1.0
+ \date 19 octobre 2026
+ */
+
+/*
+ Format du fichier (entiers et doubles dans l'ordre natif de la machine):
+	entête	"TRJ1", version, tours par bloc, nombre de robots, quantums de
+			position et d'angle, demi-largeur du monde
+	blocs	premier tour, nombre de tours, nombre de particules puis image des
+			particules au début du bloc (x, y, rayon, énergie), colonnes des
+			robots et évènements de chaque tour
+	index	position, premier tour et nombre de tours de chaque bloc
+	fin		nombre de blocs, position de l'index, "FTRJ"
+ Une colonne contient une grandeur quantifiée (x, y, angle ou cible) d'un robot
+ pour tous les tours du bloc: première valeur puis différences, en zigzag et
+ varint; une suite de différences nulles est codée par 0 et sa longueur - 1.
+ Les évènements d'un tour sont précédés de leur taille en octets: décès (0,
+ indice) ou naissance (1, x, y, rayon, énergie).
+ Le tour 0 est l'état à l'ouverture de l'enregistrement, sans évènement; le
+ tour k est l'état après k tours de simulation (version 3; en version 2 le
+ premier enregistrement suivait déjà un tour).
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include <pthread.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "robot.h"
+#include "particule.h"
+#include "trajectoire.h"
+
+#define TAILLE_BLOC			64
+#define QUANTUM_POSITION	1e-4
+#define QUANTUM_ANGLE		1e-5
+#define NB_CHAMPS			4
+#define CHAMP_X				0
+#define CHAMP_Y				1
+#define CHAMP_ANGLE			2
+#define CHAMP_CIBLE			3
+#define EVT_DECES			0
+#define EVT_NAISSANCE		1
+#define VERSION				3
+#define MAGIQUE_ENTETE		"TRJ1"
+#define MAGIQUE_FIN			"FTRJ"
+#define TAILLE_MAGIQUE		4
+#define TAILLE_ENTETE		(TAILLE_MAGIQUE + 3*sizeof(uint32_t) + 3*sizeof(double))
+#define TAILLE_ENTREE		(sizeof(uint64_t) + 2*sizeof(uint32_t))
+#define TAILLE_FIN			(sizeof(uint32_t) + sizeof(uint64_t) + TAILLE_MAGIQUE)
+#define NB_VALEURS_PARTICULE	4
+#define CAPACITE_MIN		256
+
+// tampon d'octets extensible
+typedef struct Octets OCTETS;
+struct Octets
+{
+	unsigned char *donnees;
+	size_t taille;
+	size_t capacite;
+};
+
+// bloc brut rempli par la simulation: image des particules au début du bloc,
+// colonnes quantifiées des robots [champ][robot][tour] et évènements déjà
+// encodés, fin_evenements[k] étant la fin de ceux du tour k
+typedef struct Bloc BLOC;
+struct Bloc
+{
+	unsigned int premier_tour;
+	unsigned int nb_tours;
+	int nb_particules;
+	int capacite_particules;
+	C2D *cercles;
+	double *energies;
+	int64_t *colonnes;
+	size_t fin_evenements[TAILLE_BLOC];
+	OCTETS evenements;
+};
+
+// entrée de l'index des blocs
+typedef struct Entree ENTREE;
+struct Entree
+{
+	uint64_t position;
+	uint32_t premier_tour;
+	uint32_t nb_tours;
+};
+
+struct Lecteur
+{
+	unsigned char *carte;
+	size_t taille;
+	int nb_robots;
+	unsigned int taille_bloc;
+	double quantum_position;
+	double quantum_angle;
+	double dmax;
+	int nb_blocs;
+	ENTREE *index;
+	unsigned int nb_tours;
+	// bloc décodé: colonnes et début des évènements dans la carte
+	int bloc;
+	int64_t *colonnes;
+	const unsigned char *evenements;
+	const unsigned char *fin_bloc;
+	// état courant: tour relatif au bloc dont les évènements ont été rejoués
+	// (-1 pour l'image du début du bloc) et position de lecture des évènements
+	int tour;
+	const unsigned char *lecture;
+	int nb_particules;
+	int capacite_particules;
+	C2D *cercles;
+	double *energies;
+};
+
+// enregistrement: l'état partagé avec le fil d'écriture est protégé par verrou
+static bool actif = false;
+static FILE *fichier = NULL;
+static int nb_robots = 0;
+static unsigned int tour = 0;
+static BLOC blocs[2];
+static BLOC *courant = NULL;
+static BLOC *plein = NULL;
+static bool fin = false;
+static pthread_t ecrivain;
+static pthread_mutex_t verrou = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t changement = PTHREAD_COND_INITIALIZER;
+// propres au fil d'écriture tant qu'il tourne
+static ENTREE *index_blocs = NULL;
+static int nb_blocs = 0;
+static int capacite_index = 0;
+static OCTETS encodage = {NULL, 0, 0};
+
+static void octets_reserver(OCTETS *octets, size_t n);
+static void octets_ajouter(OCTETS *octets, const void *donnees, size_t n);
+static void octets_varint(OCTETS *octets, uint64_t valeur);
+static uint64_t zigzag(int64_t valeur);
+static int64_t dezigzag(uint64_t valeur);
+static void bloc_preparer(BLOC *bloc);
+static void bloc_liberer(BLOC *bloc);
+static void trajectoire_remettre(void);
+static void* trajectoire_ecrire(void *inutilise);
+static void bloc_encoder(BLOC *bloc);
+static bool lire_varint(const unsigned char **p, const unsigned char *fin_donnees,
+						uint64_t *valeur);
+static bool lire_octets(const unsigned char **p, const unsigned char *fin_donnees,
+						void *destination, size_t n);
+static bool lecteur_decoder_bloc(LECTEUR *lecteur, int bloc);
+static bool lecteur_rejouer(LECTEUR *lecteur, int tour_bloc);
+static void lecteur_reserver(LECTEUR *lecteur, int nb);
+
+bool trajectoire_ouvrir(const char *nom_fichier, double dmax)
+{
+	static bool fermeture_prevue = false;
+	uint32_t entiers[3] = {VERSION, TAILLE_BLOC, 0};
+	double reels[3] = {QUANTUM_POSITION, QUANTUM_ANGLE, dmax};
+	int i;
+
+	trajectoire_fermer();
+	if (!(fichier = fopen(nom_fichier, "wb")))
+		return false;
+	nb_robots = robot_nb_robots();
+	entiers[2] = nb_robots;
+	fwrite(MAGIQUE_ENTETE, 1, TAILLE_MAGIQUE, fichier);
+	fwrite(entiers, sizeof(uint32_t), 3, fichier);
+	fwrite(reels, sizeof(double), 3, fichier);
+	for (i = 0; i < 2; i++)
+	{
+		memset(&blocs[i], 0, sizeof(BLOC));
+		if (nb_robots && !(blocs[i].colonnes =
+			malloc(NB_CHAMPS*nb_robots*TAILLE_BLOC*sizeof(int64_t))))
+			exit(EXIT_FAILURE);
+	}
+	tour = 0;
+	nb_blocs = 0;
+	courant = &blocs[0];
+	plein = NULL;
+	fin = false;
+	bloc_preparer(courant);
+	if (pthread_create(&ecrivain, NULL, trajectoire_ecrire, NULL))
+	{
+		fclose(fichier);
+		bloc_liberer(&blocs[0]);
+		bloc_liberer(&blocs[1]);
+		return false;
+	}
+	actif = true;
+	trajectoire_enregistrer_tour();
+	// un fichier dont l'index manque est illisible: la sortie du programme
+	// termine aussi l'enregistrement
+	if (!fermeture_prevue)
+	{
+		atexit(trajectoire_fermer);
+		fermeture_prevue = true;
+	}
+	return true;
+}
+
+void trajectoire_fermer(void)
+{
+	uint32_t valeurs[2];
+	uint64_t position;
+	int i;
+
+	if (!actif)
+		return;
+	actif = false;
+	if (courant->nb_tours)
+		trajectoire_remettre();
+	pthread_mutex_lock(&verrou);
+	fin = true;
+	pthread_cond_broadcast(&changement);
+	pthread_mutex_unlock(&verrou);
+	pthread_join(ecrivain, NULL);
+
+	position = ftell(fichier);
+	for (i = 0; i < nb_blocs; i++)
+	{
+		valeurs[0] = index_blocs[i].premier_tour;
+		valeurs[1] = index_blocs[i].nb_tours;
+		fwrite(&index_blocs[i].position, sizeof(uint64_t), 1, fichier);
+		fwrite(valeurs, sizeof(uint32_t), 2, fichier);
+	}
+	valeurs[0] = nb_blocs;
+	fwrite(valeurs, sizeof(uint32_t), 1, fichier);
+	fwrite(&position, sizeof(uint64_t), 1, fichier);
+	fwrite(MAGIQUE_FIN, 1, TAILLE_MAGIQUE, fichier);
+	fclose(fichier);
+	fichier = NULL;
+	bloc_liberer(&blocs[0]);
+	bloc_liberer(&blocs[1]);
+	free(index_blocs);
+	index_blocs = NULL;
+	capacite_index = 0;
+	free(encodage.donnees);
+	encodage.donnees = NULL;
+	encodage.capacite = 0;
+}
+
+bool trajectoire_active(void)
+{
+	return actif;
+}
+
+void trajectoire_enregistrer_tour(void)
+{
+	int i;
+	unsigned int k;
+	C2D position;
+
+	if (!actif)
+		return;
+	k = courant->nb_tours;
+	for (i = 0; i < nb_robots; i++)
+	{
+		position = robot_position(i+1);
+		courant->colonnes[(CHAMP_X*nb_robots + i)*TAILLE_BLOC + k] =
+			llround(position.centre.x/QUANTUM_POSITION);
+		courant->colonnes[(CHAMP_Y*nb_robots + i)*TAILLE_BLOC + k] =
+			llround(position.centre.y/QUANTUM_POSITION);
+		courant->colonnes[(CHAMP_ANGLE*nb_robots + i)*TAILLE_BLOC + k] =
+			llround(robot_orientation(i+1)/QUANTUM_ANGLE);
+		courant->colonnes[(CHAMP_CIBLE*nb_robots + i)*TAILLE_BLOC + k] =
+			robot_particule_cible(i+1);
+	}
+	courant->fin_evenements[k] = courant->evenements.taille;
+	courant->nb_tours++;
+	tour++;
+	if (courant->nb_tours == TAILLE_BLOC)
+	{
+		trajectoire_remettre();
+		bloc_preparer(courant);
+	}
+}
+
+void trajectoire_naissance(C2D cercle, double energie)
+{
+	unsigned char type = EVT_NAISSANCE;
+	double valeurs[NB_VALEURS_PARTICULE] = {cercle.centre.x, cercle.centre.y,
+											cercle.rayon, energie};
+	if (!actif)
+		return;
+	octets_ajouter(&courant->evenements, &type, 1);
+	octets_ajouter(&courant->evenements, valeurs, sizeof(valeurs));
+}
+
+void trajectoire_deces(int indice)
+{
+	unsigned char type = EVT_DECES;
+	if (!actif)
+		return;
+	octets_ajouter(&courant->evenements, &type, 1);
+	octets_varint(&courant->evenements, indice);
+}
+
+// remet le bloc courant au fil d'écriture; l'autre bloc, écrit entre-temps,
+// devient le bloc courant
+static void trajectoire_remettre(void)
+{
+	pthread_mutex_lock(&verrou);
+	while (plein)
+		pthread_cond_wait(&changement, &verrou);
+	plein = courant;
+	pthread_cond_broadcast(&changement);
+	pthread_mutex_unlock(&verrou);
+	courant = courant == &blocs[0] ? &blocs[1] : &blocs[0];
+}
+
+static void* trajectoire_ecrire(void *inutilise)
+{
+	BLOC *bloc;
+	(void)inutilise;
+	while (true)
+	{
+		pthread_mutex_lock(&verrou);
+		while (!plein && !fin)
+			pthread_cond_wait(&changement, &verrou);
+		bloc = plein;
+		pthread_mutex_unlock(&verrou);
+		if (!bloc)
+			break;
+		bloc_encoder(bloc);
+		pthread_mutex_lock(&verrou);
+		plein = NULL;
+		pthread_cond_broadcast(&changement);
+		pthread_mutex_unlock(&verrou);
+	}
+	return NULL;
+}
+
+// l'image des particules est prise au début du bloc, avant le premier tour
+static void bloc_preparer(BLOC *bloc)
+{
+	int nb_part = particule_nb_particules();
+	bloc->premier_tour = tour;
+	bloc->nb_tours = 0;
+	bloc->evenements.taille = 0;
+	if (nb_part > bloc->capacite_particules)
+	{
+		bloc->capacite_particules = nb_part;
+		if (!(bloc->cercles = realloc(bloc->cercles, nb_part*sizeof(C2D))) ||
+			!(bloc->energies = realloc(bloc->energies, nb_part*sizeof(double))))
+			exit(EXIT_FAILURE);
+	}
+	bloc->nb_particules = nb_part;
+	particule_exporter(bloc->cercles, bloc->energies);
+}
+
+static void bloc_liberer(BLOC *bloc)
+{
+	free(bloc->cercles);
+	free(bloc->energies);
+	free(bloc->colonnes);
+	free(bloc->evenements.donnees);
+	memset(bloc, 0, sizeof(BLOC));
+}
+
+static void bloc_encoder(BLOC *bloc)
+{
+	uint32_t entete[3] = {bloc->premier_tour, bloc->nb_tours, bloc->nb_particules};
+	double valeurs[NB_VALEURS_PARTICULE];
+	const int64_t *colonne;
+	int64_t precedent, delta;
+	unsigned int k, nuls;
+	size_t debut;
+	int i;
+
+	encodage.taille = 0;
+	octets_ajouter(&encodage, entete, sizeof(entete));
+	for (i = 0; i < bloc->nb_particules; i++)
+	{
+		valeurs[0] = bloc->cercles[i].centre.x;
+		valeurs[1] = bloc->cercles[i].centre.y;
+		valeurs[2] = bloc->cercles[i].rayon;
+		valeurs[3] = bloc->energies[i];
+		octets_ajouter(&encodage, valeurs, sizeof(valeurs));
+	}
+	for (i = 0; i < NB_CHAMPS*nb_robots; i++)
+	{
+		colonne = &bloc->colonnes[i*TAILLE_BLOC];
+		precedent = 0;
+		for (k = 0; k < bloc->nb_tours; k++)
+		{
+			delta = colonne[k] - precedent;
+			precedent = colonne[k];
+			if (delta)
+			{
+				octets_varint(&encodage, zigzag(delta));
+				continue;
+			}
+			for (nuls = 1; k+1 < bloc->nb_tours && colonne[k+1] == precedent; k++)
+				nuls++;
+			octets_varint(&encodage, 0);
+			octets_varint(&encodage, nuls-1);
+		}
+	}
+	for (k = 0, debut = 0; k < bloc->nb_tours; k++)
+	{
+		octets_varint(&encodage, bloc->fin_evenements[k] - debut);
+		octets_ajouter(&encodage, bloc->evenements.donnees + debut,
+					   bloc->fin_evenements[k] - debut);
+		debut = bloc->fin_evenements[k];
+	}
+
+	if (nb_blocs == capacite_index)
+	{
+		capacite_index = capacite_index ? 2*capacite_index : CAPACITE_MIN;
+		if (!(index_blocs = realloc(index_blocs, capacite_index*sizeof(ENTREE))))
+			exit(EXIT_FAILURE);
+	}
+	index_blocs[nb_blocs].position = ftell(fichier);
+	index_blocs[nb_blocs].premier_tour = bloc->premier_tour;
+	index_blocs[nb_blocs].nb_tours = bloc->nb_tours;
+	nb_blocs++;
+	fwrite(encodage.donnees, 1, encodage.taille, fichier);
+}
+
+static void octets_reserver(OCTETS *octets, size_t n)
+{
+	if (octets->taille + n <= octets->capacite)
+		return;
+	if (!octets->capacite)
+		octets->capacite = CAPACITE_MIN;
+	while (octets->taille + n > octets->capacite)
+		octets->capacite *= 2;
+	if (!(octets->donnees = realloc(octets->donnees, octets->capacite)))
+		exit(EXIT_FAILURE);
+}
+
+static void octets_ajouter(OCTETS *octets, const void *donnees, size_t n)
+{
+	octets_reserver(octets, n);
+	memcpy(octets->donnees + octets->taille, donnees, n);
+	octets->taille += n;
+}
+
+static void octets_varint(OCTETS *octets, uint64_t valeur)
+{
+	octets_reserver(octets, 10);
+	while (valeur >= 0x80)
+	{
+		octets->donnees[octets->taille++] = (unsigned char)(valeur | 0x80);
+		valeur >>= 7;
+	}
+	octets->donnees[octets->taille++] = (unsigned char)valeur;
+}
+
+static uint64_t zigzag(int64_t valeur)
+{
+	return ((uint64_t)valeur << 1) ^ (uint64_t)(valeur >> 63);
+}
+
+static int64_t dezigzag(uint64_t valeur)
+{
+	return (int64_t)(valeur >> 1) ^ -(int64_t)(valeur & 1);
+}
+
+LECTEUR* trajectoire_lecteur_ouvrir(const char *nom_fichier)
+{
+	LECTEUR *lecteur;
+	struct stat infos;
+	const unsigned char *p, *fin_carte;
+	uint32_t entiers[3], nb;
+	uint64_t position;
+	int descripteur, i;
+
+	if ((descripteur = open(nom_fichier, O_RDONLY)) < 0)
+		return NULL;
+	if (fstat(descripteur, &infos) < 0 ||
+		(size_t)infos.st_size < TAILLE_ENTETE + TAILLE_FIN)
+	{
+		close(descripteur);
+		return NULL;
+	}
+	if (!(lecteur = calloc(1, sizeof(LECTEUR))))
+		exit(EXIT_FAILURE);
+	lecteur->taille = infos.st_size;
+	lecteur->carte = mmap(NULL, lecteur->taille, PROT_READ, MAP_PRIVATE,
+						  descripteur, 0);
+	close(descripteur);
+	if (lecteur->carte == MAP_FAILED)
+	{
+		free(lecteur);
+		return NULL;
+	}
+	lecteur->bloc = -1;
+	p = lecteur->carte;
+	fin_carte = lecteur->carte + lecteur->taille;
+	if (memcmp(p, MAGIQUE_ENTETE, TAILLE_MAGIQUE) ||
+		memcmp(fin_carte - TAILLE_MAGIQUE, MAGIQUE_FIN, TAILLE_MAGIQUE))
+	{
+		trajectoire_lecteur_fermer(lecteur);
+		return NULL;
+	}
+	p += TAILLE_MAGIQUE;
+	lire_octets(&p, fin_carte, entiers, sizeof(entiers));
+	lire_octets(&p, fin_carte, &lecteur->quantum_position, sizeof(double));
+	lire_octets(&p, fin_carte, &lecteur->quantum_angle, sizeof(double));
+	lire_octets(&p, fin_carte, &lecteur->dmax, sizeof(double));
+	lecteur->taille_bloc = entiers[1];
+	lecteur->nb_robots = entiers[2];
+
+	p = fin_carte - TAILLE_FIN;
+	lire_octets(&p, fin_carte, &nb, sizeof(uint32_t));
+	lire_octets(&p, fin_carte, &position, sizeof(uint64_t));
+	if (entiers[0] != VERSION || !lecteur->taille_bloc ||
+		position + (uint64_t)nb*TAILLE_ENTREE != lecteur->taille - TAILLE_FIN)
+	{
+		trajectoire_lecteur_fermer(lecteur);
+		return NULL;
+	}
+	lecteur->nb_blocs = nb;
+	if (!(lecteur->index = malloc((nb ? nb : 1)*sizeof(ENTREE))) ||
+		!(lecteur->colonnes = malloc((NB_CHAMPS*lecteur->nb_robots*
+									  lecteur->taille_bloc + 1)*sizeof(int64_t))))
+		exit(EXIT_FAILURE);
+	p = lecteur->carte + position;
+	for (i = 0; i < lecteur->nb_blocs; i++)
+	{
+		lire_octets(&p, fin_carte, &lecteur->index[i].position, sizeof(uint64_t));
+		lire_octets(&p, fin_carte, &lecteur->index[i].premier_tour,
+					sizeof(uint32_t));
+		lire_octets(&p, fin_carte, &lecteur->index[i].nb_tours, sizeof(uint32_t));
+		lecteur->nb_tours += lecteur->index[i].nb_tours;
+	}
+	return lecteur;
+}
+
+void trajectoire_lecteur_fermer(LECTEUR *lecteur)
+{
+	if (!lecteur)
+		return;
+	munmap(lecteur->carte, lecteur->taille);
+	free(lecteur->index);
+	free(lecteur->colonnes);
+	free(lecteur->cercles);
+	free(lecteur->energies);
+	free(lecteur);
+}
+
+unsigned int trajectoire_lecteur_nb_tours(const LECTEUR *lecteur)
+{
+	return lecteur->nb_tours;
+}
+
+int trajectoire_lecteur_nb_robots(const LECTEUR *lecteur)
+{
+	return lecteur->nb_robots;
+}
+
+double trajectoire_lecteur_dmax(const LECTEUR *lecteur)
+{
+	return lecteur->dmax;
+}
+
+// tous les blocs sauf le dernier ont taille_bloc tours: le bloc d'un tour est
+// obtenu par division, puis vérifié dans l'index
+bool trajectoire_lecteur_aller(LECTEUR *lecteur, unsigned int tour_cherche)
+{
+	int bloc;
+	ENTREE *entree;
+
+	if (tour_cherche >= lecteur->nb_tours)
+		return false;
+	bloc = tour_cherche/lecteur->taille_bloc;
+	if (bloc >= lecteur->nb_blocs)
+		return false;
+	entree = &lecteur->index[bloc];
+	if (tour_cherche < entree->premier_tour ||
+		tour_cherche >= entree->premier_tour + entree->nb_tours)
+		return false;
+	if (bloc != lecteur->bloc && !lecteur_decoder_bloc(lecteur, bloc))
+		return false;
+	return lecteur_rejouer(lecteur, tour_cherche - entree->premier_tour);
+}
+
+POSE trajectoire_lecteur_robot(const LECTEUR *lecteur, int i)
+{
+	POSE pose;
+	int taille = lecteur->taille_bloc, k = lecteur->tour;
+	const int64_t *colonnes = lecteur->colonnes;
+	i--;
+	pose.centre.x = colonnes[(CHAMP_X*lecteur->nb_robots + i)*taille + k]*
+					lecteur->quantum_position;
+	pose.centre.y = colonnes[(CHAMP_Y*lecteur->nb_robots + i)*taille + k]*
+					lecteur->quantum_position;
+	pose.angle = colonnes[(CHAMP_ANGLE*lecteur->nb_robots + i)*taille + k]*
+				 lecteur->quantum_angle;
+	pose.cible = colonnes[(CHAMP_CIBLE*lecteur->nb_robots + i)*taille + k];
+	return pose;
+}
+
+int trajectoire_lecteur_nb_particules(const LECTEUR *lecteur)
+{
+	return lecteur->nb_particules;
+}
+
+C2D trajectoire_lecteur_particule(const LECTEUR *lecteur, int i)
+{
+	return lecteur->cercles[i-1];
+}
+
+double trajectoire_lecteur_energie(const LECTEUR *lecteur, int i)
+{
+	return lecteur->energies[i-1];
+}
+
+// décode les colonnes des robots et repère le début des évènements du bloc
+static bool lecteur_decoder_bloc(LECTEUR *lecteur, int bloc)
+{
+	const unsigned char *p = lecteur->carte + lecteur->index[bloc].position;
+	const unsigned char *fin_carte = lecteur->carte + lecteur->taille;
+	uint32_t entete[3];
+	uint64_t valeur, nuls;
+	int64_t precedent, *colonne;
+	unsigned int k, nb_tours;
+	int i;
+
+	lecteur->bloc = -1;
+	if (!lire_octets(&p, fin_carte, entete, sizeof(entete)) ||
+		entete[1] != lecteur->index[bloc].nb_tours ||
+		entete[1] > lecteur->taille_bloc ||
+		(size_t)(fin_carte - p)/(NB_VALEURS_PARTICULE*sizeof(double)) < entete[2])
+		return false;
+	nb_tours = entete[1];
+	p += (size_t)entete[2]*NB_VALEURS_PARTICULE*sizeof(double);
+	for (i = 0; i < NB_CHAMPS*lecteur->nb_robots; i++)
+	{
+		colonne = &lecteur->colonnes[i*lecteur->taille_bloc];
+		precedent = 0;
+		for (k = 0; k < nb_tours; )
+		{
+			if (!lire_varint(&p, fin_carte, &valeur))
+				return false;
+			if (valeur)
+			{
+				precedent += dezigzag(valeur);
+				colonne[k++] = precedent;
+				continue;
+			}
+			if (!lire_varint(&p, fin_carte, &nuls) || nuls >= nb_tours - k)
+				return false;
+			for (nuls++; nuls > 0; nuls--)
+				colonne[k++] = precedent;
+		}
+	}
+	lecteur->evenements = p;
+	lecteur->fin_bloc = bloc+1 < lecteur->nb_blocs ?
+						lecteur->carte + lecteur->index[bloc+1].position :
+						lecteur->carte + (lecteur->taille - TAILLE_FIN -
+										  lecteur->nb_blocs*TAILLE_ENTREE);
+	if (lecteur->fin_bloc < p || lecteur->fin_bloc > fin_carte)
+		return false;
+	lecteur->bloc = bloc;
+	lecteur->tour = -1;
+	return true;
+}
+
+// rejoue les évènements jusqu'au tour tour_bloc inclus, depuis l'image du début
+// du bloc si ce tour précède l'état courant
+static bool lecteur_rejouer(LECTEUR *lecteur, int tour_bloc)
+{
+	const unsigned char *p, *fin_tour;
+	const unsigned char *debut = lecteur->carte +
+								 lecteur->index[lecteur->bloc].position;
+	uint32_t entete[3];
+	uint64_t taille, indice;
+	double valeurs[NB_VALEURS_PARTICULE];
+	unsigned char type;
+	int i;
+
+	if (tour_bloc < lecteur->tour || lecteur->tour < 0)
+	{
+		p = debut;
+		lire_octets(&p, lecteur->fin_bloc, entete, sizeof(entete));
+		lecteur_reserver(lecteur, entete[2]);
+		for (i = 0; i < (int)entete[2]; i++)
+		{
+			lire_octets(&p, lecteur->fin_bloc, valeurs, sizeof(valeurs));
+			lecteur->cercles[i].centre.x = valeurs[0];
+			lecteur->cercles[i].centre.y = valeurs[1];
+			lecteur->cercles[i].rayon = valeurs[2];
+			lecteur->energies[i] = valeurs[3];
+		}
+		lecteur->nb_particules = entete[2];
+		lecteur->lecture = lecteur->evenements;
+		lecteur->tour = -1;
+	}
+	p = lecteur->lecture;
+	for (; lecteur->tour < tour_bloc; lecteur->tour++)
+	{
+		if (!lire_varint(&p, lecteur->fin_bloc, &taille) ||
+			taille > (uint64_t)(lecteur->fin_bloc - p))
+			return false;
+		for (fin_tour = p + taille; p < fin_tour; )
+		{
+			if (!lire_octets(&p, fin_tour, &type, 1))
+				return false;
+			if (type == EVT_DECES)
+			{
+				if (!lire_varint(&p, fin_tour, &indice) || indice < 1 ||
+					indice > (uint64_t)lecteur->nb_particules)
+					return false;
+				memmove(&lecteur->cercles[indice-1], &lecteur->cercles[indice],
+						(lecteur->nb_particules - indice)*sizeof(C2D));
+				memmove(&lecteur->energies[indice-1], &lecteur->energies[indice],
+						(lecteur->nb_particules - indice)*sizeof(double));
+				lecteur->nb_particules--;
+			}
+			else if (type == EVT_NAISSANCE &&
+					 lire_octets(&p, fin_tour, valeurs, sizeof(valeurs)))
+			{
+				lecteur_reserver(lecteur, lecteur->nb_particules + 1);
+				i = lecteur->nb_particules++;
+				lecteur->cercles[i].centre.x = valeurs[0];
+				lecteur->cercles[i].centre.y = valeurs[1];
+				lecteur->cercles[i].rayon = valeurs[2];
+				lecteur->energies[i] = valeurs[3];
+			}
+			else
+				return false;
+		}
+	}
+	lecteur->lecture = p;
+	return true;
+}
+
+static void lecteur_reserver(LECTEUR *lecteur, int nb)
+{
+	if (nb <= lecteur->capacite_particules)
+		return;
+	lecteur->capacite_particules = nb > 2*lecteur->capacite_particules ?
+								   nb : 2*lecteur->capacite_particules;
+	if (!(lecteur->cercles = realloc(lecteur->cercles,
+									 lecteur->capacite_particules*sizeof(C2D))) ||
+		!(lecteur->energies = realloc(lecteur->energies,
+									  lecteur->capacite_particules*sizeof(double))))
+		exit(EXIT_FAILURE);
+}
+
+static bool lire_varint(const unsigned char **p, const unsigned char *fin_donnees,
+						uint64_t *valeur)
+{
+	int decalage;
+	*valeur = 0;
+	for (decalage = 0; *p < fin_donnees && decalage < 64; decalage += 7)
+	{
+		*valeur |= (uint64_t)(**p & 0x7f) << decalage;
+		if (!(*(*p)++ & 0x80))
+			return true;
+	}
+	return false;
+}
+
+static bool lire_octets(const unsigned char **p, const unsigned char *fin_donnees,
+						void *destination, size_t n)
+{
+	if ((size_t)(fin_donnees - *p) < n)
+		return false;
+	memcpy(destination, *p, n);
+	*p += n;
+	return true;
+}
@@ -0,0 +1,139 @@
+/*!
+ \file trajectoire.h
+ \brief Module d'enregistrement et de relecture des trajectoires: poses des
+        robots à chaque tour, naissances et disparitions des particules
+ \author agent
+ \group Sylvain Pellegrini
+		Simon Gilgien
+ \version 1.0
+ \date 19 octobre 2026
+ */
+
+#ifndef TRAJECTOIRE_H
+#define TRAJECTOIRE_H
+
+#include <stdbool.h>
+#include "utilitaire.h"
+
+/**
+ * \brief	Pose d'un robot à la fin d'un tour; les coordonnées et l'angle sont
+ *			quantifiés à l'enregistrement (1e-4 et 1e-5 rad).
+ */
+typedef struct Pose POSE;
+struct Pose
+{
+	S2D centre;
+	double angle;
+	int cible;
+};
+
+/**
+ * \brief	Lecteur d'un fichier de trajectoire projeté en mémoire.
+ */
+typedef struct Lecteur LECTEUR;
+
+/**
+ * \brief	Commence l'enregistrement de la simulation chargée dans un fichier,
+ *			dont l'état courant devient le tour 0. L'encodage et l'écriture ont
+ *			lieu sur un fil d'exécution séparé.
+ *			Un enregistrement déjà en cours est d'abord terminé.
+ * \param nom_fichier	Le nom du fichier à écrire.
+ * \param dmax			La demi-largeur du monde, conservée pour la relecture.
+ * \return	Vrai si le fichier a pu être créé.
+ */
+bool trajectoire_ouvrir(const char *nom_fichier, double dmax);
+
+/**
+ * \brief	Termine l'enregistrement en cours: écrit le dernier bloc et l'index,
+ *			puis ferme le fichier. Sans effet si aucun enregistrement n'est actif.
+ */
+void trajectoire_fermer(void);
+
+/**
+ * \brief	Indique si un enregistrement est en cours.
+ */
+bool trajectoire_active(void);
+
+/**
+ * \brief	Enregistre la pose de tous les robots à la fin d'un tour de
+ *			simulation, avec les évènements de particules du tour. Sans effet
+ *			si aucun enregistrement n'est actif, comme les deux fonctions
+ *			suivantes.
+ */
+void trajectoire_enregistrer_tour(void);
+
+/**
+ * \brief	Signale l'ajout d'une particule en fin de liste pendant le tour.
+ * \param cercle	La position et le rayon de la nouvelle particule.
+ * \param energie	Son énergie.
+ */
+void trajectoire_naissance(C2D cercle, double energie);
+
+/**
+ * \brief	Signale l'élimination de la particule d'indice donné pendant le tour;
+ *			les particules suivantes voient leur indice diminuer de un.
+ * \param indice	L'indice de la particule éliminée.
+ */
+void trajectoire_deces(int indice);
+
+/**
+ * \brief	Ouvre un fichier de trajectoire en lecture.
+ * \param nom_fichier	Le nom du fichier à lire.
+ * \return	Le lecteur, ou NULL si le fichier est absent ou invalide.
+ */
+LECTEUR* trajectoire_lecteur_ouvrir(const char *nom_fichier);
+
+/**
+ * \brief	Ferme un lecteur et libère ses ressources.
+ */
+void trajectoire_lecteur_fermer(LECTEUR *lecteur);
+
+/**
+ * \brief	Retourne le nombre de tours enregistrés, numérotés à partir de 0:
+ *			le tour 0 est l'état de départ, le tour k l'état après k tours.
+ */
+unsigned int trajectoire_lecteur_nb_tours(const LECTEUR *lecteur);
+
+/**
+ * \brief	Retourne le nombre de robots enregistrés.
+ */
+int trajectoire_lecteur_nb_robots(const LECTEUR *lecteur);
+
+/**
+ * \brief	Retourne la demi-largeur du monde enregistré.
+ */
+double trajectoire_lecteur_dmax(const LECTEUR *lecteur);
+
+/**
+ * \brief	Place le lecteur sur l'état après le tour donné. Le bloc contenant
+ *			le tour est trouvé directement par l'index; seuls ses évènements de
+ *			particules antérieurs au tour sont rejoués.
+ * \param tour	Le tour, inférieur à trajectoire_lecteur_nb_tours().
+ * \return	Faux si le tour n'existe pas ou si le bloc est corrompu.
+ */
+bool trajectoire_lecteur_aller(LECTEUR *lecteur, unsigned int tour);
+
+/**
+ * \brief	Retourne la pose d'un robot au tour courant du lecteur.
+ * \param i	L'indice du robot, dans [1, nb_robots].
+ */
+POSE trajectoire_lecteur_robot(const LECTEUR *lecteur, int i);
+
+/**
+ * \brief	Retourne le nombre de particules au tour courant du lecteur.
+ */
+int trajectoire_lecteur_nb_particules(const LECTEUR *lecteur);
+
+/**
+ * \brief	Retourne la position d'une particule au tour courant du lecteur.
+ * \param i	L'indice de la particule, dans [1, nb_particules].
+ */
+C2D trajectoire_lecteur_particule(const LECTEUR *lecteur, int i);
+
+/**
+ * \brief	Retourne l'énergie d'une particule au tour courant du lecteur.
+ * \param i	L'indice de la particule, dans [1, nb_particules].
+ */
+double trajectoire_lecteur_energie(const LECTEUR *lecteur, int i);
+
+#endif
